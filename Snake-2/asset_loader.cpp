@@ -0,0 +1,105 @@
+#include "asset_loader.h"
+
+#include <SDL_image.h>
+
+AssetLoader::AssetLoader(int threadCount)
+    : pool(threadCount)
+{
+    dispatcher = std::thread(&AssetLoader::dispatchLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    dispatcher.join();
+}
+
+int AssetLoader::add(AssetKind kind, const std::string& path)
+{
+    return add(kind, path, NULL, 0);
+}
+
+int AssetLoader::add(AssetKind kind, const std::string& name, const void* data, size_t size)
+{
+    std::unique_ptr<Asset> asset(new Asset());
+    asset->kind = kind;
+    asset->path = name;
+    asset->data = data;
+    asset->size = size;
+
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = (int)assets.size();
+        assets.push_back(std::move(asset));
+        queued.push_back(id);
+    }
+    changed.notify_all();
+    return id;
+}
+
+int AssetLoader::next()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return !finished.empty() || returned == (int)assets.size(); });
+    if (finished.empty()) return -1;
+
+    int id = finished.front();
+    finished.erase(finished.begin());
+    returned++;
+    return id;
+}
+
+// Hands queued files to the pool a batch at a time. parallelFor() blocks, so
+// it runs here rather than on the caller's thread; files added meanwhile go
+// out with the next batch.
+void AssetLoader::dispatchLoop()
+{
+    for (;;) {
+        std::vector<Asset*> batch;
+        std::vector<int> ids;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return stopping || !queued.empty(); });
+            if (queued.empty()) return;
+            ids.swap(queued);
+            for (int id : ids) batch.push_back(assets[id].get());
+        }
+
+        pool.parallelFor(0, (int)batch.size(), 1, [&](int begin, int end, int) {
+            for (int i = begin; i < end; i++) {
+                decode(*batch[i]);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.push_back(ids[i]);
+                }
+                changed.notify_all();
+            }
+        });
+    }
+}
+
+void AssetLoader::decode(Asset& asset)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    // In-memory files are read in place: the RWops only points at them.
+    SDL_RWops* rw = asset.data != NULL
+        ? SDL_RWFromConstMem(asset.data, (int)asset.size)
+        : SDL_RWFromFile(asset.path.c_str(), "rb");
+    if (rw == NULL) {
+        asset.error = SDL_GetError();
+    }
+    else if (asset.kind == ASSET_IMAGE) {
+        asset.image = IMG_Load_RW(rw, 1);
+        if (asset.image == NULL) asset.error = IMG_GetError();
+    }
+    else {
+        asset.sound = Mix_LoadWAV_RW(rw, 1);
+        if (asset.sound == NULL) asset.error = Mix_GetError();
+    }
+    asset.decodeMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
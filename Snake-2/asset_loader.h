@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include "core/thread_pool.h"
+
+enum AssetKind { ASSET_IMAGE, ASSET_SOUND };
+
+struct Asset {
+    AssetKind kind;
+    std::string path;
+    const void* data = NULL; // file contents already in memory, if not NULL
+    size_t size = 0;
+    SDL_Surface* image = NULL; // ASSET_IMAGE, NULL if decoding failed
+    Mix_Chunk* sound = NULL;   // ASSET_SOUND, NULL if decoding failed
+    double decodeMs = 0;
+    std::string error;
+};
+
+// Decodes image and sound files on a worker pool while the main thread gets
+// on with other startup work. Only decoding happens on the workers; anything
+// touching the renderer (texture uploads) stays with the caller, which picks
+// up finished assets one by one with next().
+//
+// Call IMG_Init() and Mix_Init() for the formats needed before adding files,
+// so the codec libraries are not lazily loaded from several threads at once.
+// Sounds are converted to the mixer's format, so the mixer must be open.
+class AssetLoader {
+public:
+    explicit AssetLoader(int threadCount);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Queues a file and starts decoding it as soon as a worker is free.
+    // Returns the asset id.
+    int add(AssetKind kind, const std::string& path);
+    // Same for a file already in memory, e.g. inside an AssetPack. The data
+    // must stay valid until the asset has been returned by next().
+    int add(AssetKind kind, const std::string& name, const void* data, size_t size);
+
+    // Blocks until an asset not returned before has finished and returns its
+    // id, or -1 once every added asset has been returned.
+    int next();
+
+    // Only valid for ids returned by next(). The caller owns and frees the
+    // decoded image and sound.
+    Asset& asset(int id) { return *assets[id]; }
+
+private:
+    void dispatchLoop();
+    static void decode(Asset& asset);
+
+    ThreadPool pool;
+    std::thread dispatcher;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::unique_ptr<Asset>> assets;
+    std::vector<int> queued;   // added, not yet handed to the pool
+    std::vector<int> finished; // decoded, not yet returned by next()
+    int returned = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "../core/point.h"
+
+// Each benchmark is a subcommand of SnakeBench: `SnakeBench <name> [args...]`.
+// argv[0] is the subcommand name.
+int benchTick(int argc, char* argv[]);
+int benchBatch(int argc, char* argv[]);
+int benchScaling(int argc, char* argv[]);
+int benchSnapshot(int argc, char* argv[]);
+int benchSpectator(int argc, char* argv[]);
+int benchArena(int argc, char* argv[]);
+int benchSparse(int argc, char* argv[]);
+
+// Closed path through every cell of a width x height board, used to keep a
+// snake alive indefinitely. Requires an even height.
+std::vector<Point> hamiltonianCycle(int width, int height);
+
+// The direction that moves one step from `from` to the neighbouring cell `to`.
+Direction directionTo(Point from, Point to);
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../core/arena.h"
+#include "../core/rng.h"
+#include "bench.h"
+
+// Keeps going, turning now and then, and steers round walls and bodies it is
+// about to hit. It cannot see where other heads are going, so head-on and
+// side collisions still happen.
+static uint8_t wanderMove(const Arena& arena, int snake, Rng& rng) {
+    Direction current = arena.direction(snake);
+    uint64_t x = rng.next();
+    Direction wanted = (x & 7) == 0 ? Direction((x >> 3) & 3) : current;
+    Point head = arena.head(snake);
+    for (int i = 0; i < 4; i++) {
+        Direction direction = Direction(((int)wanted + i) & 3);
+        if (direction == opposite(current)) continue;
+        Point next = moved(head, direction);
+        if (arena.inside(next) && arena.owner(next) < 0) return (uint8_t)direction;
+    }
+    return (uint8_t)wanted;
+}
+
+// Arena::step() time as the snake count grows on a fixed board, with as
+// much food as snakes. Choosing moves is timed separately and left out.
+int benchArena(int argc, char* argv[]) {
+    ArenaConfig config;
+    config.width = 1024;
+    config.height = 1024;
+    int ticks = 1000;
+    if (argc >= 3) {
+        config.width = atoi(argv[1]);
+        config.height = atoi(argv[2]);
+    }
+    if (argc >= 4) ticks = atoi(argv[3]);
+    if (config.width < 8 || config.height < 8 || (long long)config.width * config.height > 1ll << 30 || ticks < 1) {
+        std::cout << "board needs sides >= 8 and at most 2^30 cells, ticks >= 1" << std::endl;
+        return 1;
+    }
+
+    std::cout << "board " << config.width << "x" << config.height << ", " << ticks << " ticks" << std::endl;
+    std::cout << "snakes  us/tick  ns/snake  alive  head deaths  body deaths  wall deaths  food eaten" << std::endl;
+    for (int snakes = 16; snakes <= 16384; snakes *= 4) {
+        if ((long long)snakes * config.initialLength * 4 > (long long)config.width * config.height) break;
+        config.snakes = snakes;
+        config.food = snakes;
+        Arena arena(config, 1);
+        Rng rng(2);
+        std::vector<uint8_t> actions(snakes);
+
+        std::chrono::duration<double, std::micro> stepTime(0);
+        uint64_t aliveTotal = 0;
+        for (int t = 0; t < ticks; t++) {
+            for (int i = 0; i < snakes; i++) {
+                if (arena.alive(i)) {
+                    actions[i] = wanderMove(arena, i, rng);
+                    aliveTotal++;
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+            arena.step(actions.data());
+            stepTime += std::chrono::steady_clock::now() - start;
+        }
+
+        const ArenaStats& stats = arena.stats();
+        double usPerTick = stepTime.count() / ticks;
+        std::cout << snakes << "  " << usPerTick << "  " << usPerTick * 1000 / snakes << "  "
+            << (double)aliveTotal / ticks << "  " << stats.headDeaths << "  " << stats.bodyDeaths << "  "
+            << stats.wallDeaths << "  " << stats.foodEaten << std::endl;
+    }
+    return 0;
+}
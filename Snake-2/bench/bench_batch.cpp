@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../core/batch_env.h"
+#include "../core/rng.h"
+#include "bench.h"
+
+// Steps a BatchEnv with random-ish actions (keep going, occasionally turn) and
+// reports env-steps per second. Each thread owns a contiguous slice of games.
+int benchBatch(int argc, char* argv[]) {
+    int games = argc >= 2 ? atoi(argv[1]) : 16384;
+    int steps = argc >= 3 ? atoi(argv[2]) : 2000;
+    int threads = argc >= 4 ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    if (games < 1 || steps < 1) {
+        std::cout << "games and steps must be positive" << std::endl;
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > games) threads = games;
+
+    GameConfig config;
+    BatchEnv env(games, config, 1);
+    std::vector<uint8_t> actions(games);
+    std::vector<uint8_t> results(games);
+
+    auto worker = [&](int begin, int end, Rng rng) {
+        for (int s = 0; s < steps; s++) {
+            for (int i = begin; i < end; i++) {
+                uint64_t x = rng.next();
+                actions[i] = (x & 7) == 0 ? (uint8_t)((x >> 3) & 3) : (uint8_t)env.direction(i);
+            }
+            env.step(actions.data(), results.data(), begin, end);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    Rng streams(2);
+    for (int t = 0; t < threads; t++) {
+        int begin = (int)((long long)games * t / threads);
+        int end = (int)((long long)games * (t + 1) / threads);
+        pool.emplace_back(worker, begin, end, streams);
+        streams.jump();
+    }
+    for (std::thread& thread : pool) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double total = (double)games * steps;
+    std::cout << "board " << config.width << "x" << config.height << ", " << games << " games, "
+        << steps << " steps, " << threads << " threads" << std::endl;
+    std::cout << total / elapsed.count() / 1e6 << " M env-steps/sec" << std::endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <cstring>
+#include <iostream>
+
+#include "bench.h"
+
+struct BenchEntry {
+    const char* name;
+    int (*run)(int argc, char* argv[]);
+    const char* usage;
+};
+
+static const BenchEntry benches[] = {
+    { "tick", benchTick, "tick [width height]  ns per updateSnake() as the snake grows to a full board" },
+    { "batch", benchBatch, "batch [games steps threads]  BatchEnv env-steps/sec" },
+    { "scaling", benchScaling, "scaling [games steps grain]  BatchEnv on the thread pool at 1-16 threads" },
+    { "snapshot", benchSnapshot, "snapshot [width height]  ns per saveSnapshot() / restoreSnapshot()" },
+    { "spectator", benchSpectator, "spectator [width height ticks]  spectator stream bytes/tick and encode/decode ns" },
+    { "arena", benchArena, "arena [width height ticks]  Arena::step() time at 16-16384 snakes" },
+    { "sparse", benchSparse, "sparse [ticks]  ns/tick and memory for 1k-1M segment snakes on boards up to 1M x 1M" },
+};
+
+std::vector<Point> hamiltonianCycle(int width, int height) {
+    // Row 0 left to right, then rows 1..height-1 zig-zag over columns
+    // 1..width-1, then back up column 0. Closes because height is even.
+    std::vector<Point> cycle;
+    for (int x = 0; x < width; x++) cycle.push_back({ x, 0 });
+    for (int y = 1; y < height; y++) {
+        if (y % 2 == 1) {
+            for (int x = width - 1; x >= 1; x--) cycle.push_back({ x, y });
+        }
+        else {
+            for (int x = 1; x < width; x++) cycle.push_back({ x, y });
+        }
+    }
+    for (int y = height - 1; y >= 1; y--) cycle.push_back({ 0, y });
+    return cycle;
+}
+
+Direction directionTo(Point from, Point to) {
+    if (to.x > from.x) return Direction::RIGHT;
+    if (to.x < from.x) return Direction::LEFT;
+    if (to.y > from.y) return Direction::DOWN;
+    return Direction::UP;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2) {
+        for (const BenchEntry& bench : benches) {
+            if (strcmp(argv[1], bench.name) == 0) return bench.run(argc - 1, argv + 1);
+        }
+    }
+
+    std::cout << "usage: SnakeBench <benchmark> [args]" << std::endl;
+    for (const BenchEntry& bench : benches) {
+        std::cout << "  " << bench.usage << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../core/batch_env.h"
+#include "../core/rng.h"
+#include "../core/thread_pool.h"
+#include "bench.h"
+
+namespace {
+
+// One action stream per worker, padded onto its own cache line.
+struct alignas(64) WorkerRng {
+    Rng rng;
+};
+
+double stepsPerSecond(int threads, int games, int steps, int grain) {
+    GameConfig config;
+    BatchEnv env(games, config, 1);
+    ThreadPool pool(threads);
+    std::vector<uint8_t> actions(games);
+    std::vector<uint8_t> results(games);
+    std::vector<WorkerRng> rngs(threads);
+    Rng streams(2);
+    for (int t = 0; t < threads; t++) {
+        rngs[t].rng = streams;
+        streams.jump();
+    }
+
+    auto chunk = [&](int begin, int end, int worker) {
+        Rng& rng = rngs[worker].rng;
+        for (int i = begin; i < end; i++) {
+            uint64_t x = rng.next();
+            actions[i] = (x & 7) == 0 ? (uint8_t)((x >> 3) & 3) : (uint8_t)env.direction(i);
+        }
+        env.step(actions.data(), results.data(), begin, end);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) pool.parallelFor(0, games, grain, chunk);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double)games * steps / elapsed.count();
+}
+
+} // namespace
+
+// BatchEnv stepped through the work-stealing ThreadPool, one parallelFor per
+// step, at 1, 2, 4, 8 and 16 threads.
+int benchScaling(int argc, char* argv[]) {
+    int games = argc >= 2 ? atoi(argv[1]) : 65536;
+    int steps = argc >= 3 ? atoi(argv[2]) : 500;
+    int grain = argc >= 4 ? atoi(argv[3]) : 1024;
+    if (games < 1 || steps < 1 || grain < 1) {
+        std::cout << "games, steps and grain must be positive" << std::endl;
+        return 1;
+    }
+
+    std::cout << games << " games, " << steps << " steps, chunks of " << grain << std::endl;
+    std::cout << "threads  M env-steps/sec  speedup" << std::endl;
+    double base = 0;
+    for (int threads : { 1, 2, 4, 8, 16 }) {
+        double rate = stepsPerSecond(threads, games, steps, grain);
+        if (threads == 1) base = rate;
+        std::cout << threads << "  " << rate / 1e6 << "  " << rate / base << std::endl;
+    }
+    return 0;
+}
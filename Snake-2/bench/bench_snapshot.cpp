@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../core/game.h"
+#include "../core/snapshot.h"
+#include "bench.h"
+
+// saveSnapshot() / restoreSnapshot() cost for a snake laid along a
+// Hamiltonian cycle, at lengths from 3 up to a full board. Costs grow with
+// the board (the free cell order is always copied whole) more than with the
+// snake.
+int benchSnapshot(int argc, char* argv[]) {
+    GameConfig config;
+    if (argc >= 3) {
+        config.width = atoi(argv[1]);
+        config.height = atoi(argv[2]);
+    }
+    if (config.width < 2 || config.height < 2 || config.height % 2 != 0 ||
+        config.width * config.height > SNAPSHOT_MAX_CELLS) {
+        std::cout << "board needs width >= 2, an even height >= 2 and at most "
+            << SNAPSHOT_MAX_CELLS << " cells" << std::endl;
+        return 1;
+    }
+
+    const std::vector<Point> cycle = hamiltonianCycle(config.width, config.height);
+    const int n = (int)cycle.size();
+    const int repeats = 1000000;
+
+    std::vector<int> lengths;
+    for (int length = config.initialLength; length < n; length *= 2) lengths.push_back(length);
+    lengths.push_back(n);
+
+    std::cout << "board " << config.width << "x" << config.height << ", "
+        << sizeof(GameSnapshot) << " byte snapshots" << std::endl;
+    std::cout << "length  save ns  restore ns" << std::endl;
+
+    GameState game;
+    GameState restored;
+    GameSnapshot snapshot;
+    game.config = config;
+    for (int length : lengths) {
+        clearBoard(game);
+        for (int i = 0; i < length; i++) {
+            Point segment = cycle[length - 1 - i];
+            game.segments.pushBack(segment);
+            occupyCell(game, segment);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            game.tick = r; // keeps the loop from being folded into one save
+            saveSnapshot(game, snapshot);
+        }
+        auto saved = std::chrono::steady_clock::now();
+        uint64_t check = 0;
+        for (int r = 0; r < repeats; r++) {
+            restoreSnapshot(restored, snapshot);
+            check += restored.segments.size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (check != (uint64_t)length * repeats) {
+            std::cout << "restore lost segments" << std::endl;
+            return 1;
+        }
+
+        std::chrono::duration<double, std::nano> saveTime = saved - start;
+        std::chrono::duration<double, std::nano> restoreTime = end - saved;
+        std::cout << length << "  " << saveTime.count() / repeats << "  " << restoreTime.count() / repeats << std::endl;
+    }
+    return 0;
+}
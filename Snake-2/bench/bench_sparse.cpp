@@ -0,0 +1,99 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include "../core/sparse_game.h"
+#include "bench.h"
+
+// Resident memory of this process, or 0 if it cannot be read.
+static size_t residentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+#else
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return 0;
+    unsigned long size = 0, resident = 0;
+    int fields = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    return fields == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+// Cell k of a path that zig-zags across a band `band` cells wide from the
+// top left corner, so a long snake stays compact instead of one long line.
+static Point zigzag(int64_t k, int band) {
+    int row = (int)(k / band);
+    int column = (int)(k % band);
+    return { row % 2 == 0 ? column : band - 1 - column, row };
+}
+
+// Tick time and memory for snakes of 1k to 1M segments on square boards up
+// to SPARSE_MAX_SIDE a side. The snake follows a zig-zag through a 1024-wide
+// band, so every tick its head and tail cross into new chunks and out of old
+// ones now and then; food is kept off the board so the length stays fixed.
+int benchSparse(int argc, char* argv[]) {
+    int ticks = argc >= 2 ? atoi(argv[1]) : 1000000;
+    if (ticks < 1) {
+        std::cout << "ticks must be positive" << std::endl;
+        return 1;
+    }
+
+    std::cout << ticks << " ticks per run, " << CHUNK_SIDE << "x" << CHUNK_SIDE << " chunks of "
+        << sizeof(OccupancyChunk) << " bytes, RSS at start " << residentBytes() / 1024 << " KB" << std::endl;
+    std::cout << "side  length  ns/tick  chunks  chunk KB  body KB  RSS MB  dense board GB" << std::endl;
+
+    const int sides[] = { 1024, 16384, 131072, SPARSE_MAX_SIDE };
+    const int lengths[] = { 1000, 10000, 100000, 1000000 };
+    for (int side : sides) {
+        for (int length : lengths) {
+            const int band = side < 1024 ? side : 1024;
+            if ((int64_t)length + ticks > (int64_t)band * side) continue;
+
+            SparseGame game;
+            game.config.width = side;
+            game.config.height = side;
+            clearBoard(game);
+            game.segments.grow((size_t)length);
+            for (int i = length - 1; i >= 0; i--) {
+                Point segment = zigzag(i, band);
+                game.segments.pushBack(segment);
+                game.occupied.set(segment);
+            }
+            game.food = { -1, -1 };
+
+            int64_t k = length - 1;
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < ticks; t++) {
+                game.direction = directionTo(zigzag(k, band), zigzag(k + 1, band));
+                k++;
+                if (updateSnake(game) != STEP_MOVE) {
+                    std::cout << "snake died during benchmark" << std::endl;
+                    return 1;
+                }
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            // What GameState would need: a byte of Occupancy and two ints of
+            // FreeCells per cell, plus a ring slot per cell.
+            double denseBytes = (double)side * side * (1 + 2 * sizeof(int) + sizeof(Point));
+            std::cout << side << "  " << length << "  " << elapsed.count() / ticks << "  " << game.occupied.chunks()
+                << "  " << game.occupied.chunkBytes() / 1024 << "  " << length * sizeof(Point) / 1024 << "  "
+                << residentBytes() / (1024 * 1024) << "  " << denseBytes / (1024.0 * 1024 * 1024) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../core/game.h"
+#include "../core/spectator_stream.h"
+#include "bench.h"
+
+// Heads for the food along whichever axis is further off, falling back to
+// any move that does not crash this tick. Dies now and then by boxing itself
+// in, so the stream sees new games as well as long runs.
+static Direction greedyMove(const GameState& game) {
+    Point head = game.segments.front();
+    Direction preferred[4];
+    int n = 0;
+    int dx = game.food.x - head.x;
+    int dy = game.food.y - head.y;
+    Direction horizontal = dx > 0 ? Direction::RIGHT : Direction::LEFT;
+    Direction vertical = dy > 0 ? Direction::DOWN : Direction::UP;
+    if (abs(dx) >= abs(dy)) {
+        if (dx != 0) preferred[n++] = horizontal;
+        if (dy != 0) preferred[n++] = vertical;
+    }
+    else {
+        preferred[n++] = vertical;
+        if (dx != 0) preferred[n++] = horizontal;
+    }
+    for (Direction direction : { Direction::UP, Direction::LEFT, Direction::DOWN, Direction::RIGHT }) preferred[n++] = direction;
+
+    for (Direction direction : preferred) {
+        if (direction == opposite(game.direction)) continue;
+        Point next = moved(head, direction);
+        if (next.x < 0 || next.x >= game.config.width || next.y < 0 || next.y >= game.config.height) continue;
+        if (game.occupied.test(next) && next != game.segments.back()) continue;
+        return direction;
+    }
+    return game.direction;
+}
+
+static void playTick(GameState& game) {
+    if (isGameOver(step(game, greedyMove(game)))) initializeGame(game);
+}
+
+static bool sameSnake(const GameState& a, const GameState& b) {
+    if (a.segments.size() != b.segments.size() || a.food != b.food) return false;
+    for (size_t i = 0; i < a.segments.size(); i++) {
+        if (a.segments[i] != b.segments[i]) return false;
+    }
+    return true;
+}
+
+// Bytes a spectator receives per tick with keyframes at several intervals,
+// against sending the whole snake every tick. Every spectator of a game gets
+// the same frames, so the encode cost is paid once per game and the
+// bandwidth once per spectator.
+int benchSpectator(int argc, char* argv[]) {
+    GameConfig config;
+    config.width = 32;
+    config.height = 24;
+    int ticks = 1000000;
+    if (argc >= 3) {
+        config.width = atoi(argv[1]);
+        config.height = atoi(argv[2]);
+    }
+    if (argc >= 4) ticks = atoi(argv[3]);
+    if (config.width < 2 || config.height < config.initialLength || config.width > SPECTATOR_MAX_SIDE ||
+        config.height > SPECTATOR_MAX_SIDE || ticks < 1) {
+        std::cout << "board needs width >= 2, height >= " << config.initialLength << ", sides at most "
+            << SPECTATOR_MAX_SIDE << " and ticks >= 1" << std::endl;
+        return 1;
+    }
+
+    const uint64_t seed = 12345;
+    const double tickRate = 1000.0 / 130; // the front end's default
+    GameState game;
+
+    newGame(game, config, seed);
+    uint64_t snakeCells = 0;
+    for (int t = 0; t < ticks; t++) {
+        playTick(game);
+        snakeCells += game.segments.size();
+    }
+    double fullBytes = (double)(snakeCells + ticks) * sizeof(Point) / ticks; // segments plus food as Points
+
+    std::cout << "board " << config.width << "x" << config.height << ", " << ticks << " ticks, avg length "
+        << (double)snakeCells / ticks << std::endl;
+    std::cout << "whole snake every tick: " << fullBytes << " bytes/tick, "
+        << fullBytes * 8 * tickRate / 1000 << " kbit/s per spectator at " << tickRate << " Hz" << std::endl;
+    std::cout << "keyframe every (ticks)  bytes/tick  keyframes  kbit/s  vs whole  encode ns  decode ns" << std::endl;
+
+    const int intervals[] = { 0, 300, 30, 1 };
+    for (int interval : intervals) {
+        SpectatorEncoder encoder(interval);
+        SpectatorDecoder check;
+        std::vector<uint8_t> stream;
+        stream.reserve((size_t)ticks * 2);
+
+        // Checked pass: every frame must rebuild exactly the game's snake.
+        newGame(game, config, seed);
+        for (int t = 0; t < ticks; t++) {
+            playTick(game);
+            size_t before = stream.size();
+            encoder.encode(game, stream);
+            if (check.decode(stream.data() + before, stream.size() - before) != stream.size() - before ||
+                !sameSnake(game, check.state())) {
+                std::cout << "spectator view went wrong at tick " << t << std::endl;
+                return 1;
+            }
+        }
+        SpectatorStats stats = encoder.stats();
+
+        // Timed passes. The game is played a block of ticks ahead into
+        // recorded states and only the encode() calls over them are timed,
+        // so the simulation stays out of the figure without subtracting it.
+        const int BLOCK = 256;
+        std::vector<GameState> recorded(BLOCK);
+        SpectatorEncoder timedEncoder(interval);
+        std::vector<uint8_t> timedStream;
+        timedStream.reserve(stream.size());
+        std::chrono::duration<double, std::nano> encodeTime(0);
+        newGame(game, config, seed);
+        for (int first = 0; first < ticks; first += BLOCK) {
+            int count = ticks - first < BLOCK ? ticks - first : BLOCK;
+            for (int i = 0; i < count; i++) {
+                playTick(game);
+                recorded[i] = game;
+            }
+            auto blockStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; i++) timedEncoder.encode(recorded[i], timedStream);
+            encodeTime += std::chrono::steady_clock::now() - blockStart;
+        }
+        if (timedStream != stream) {
+            std::cout << "encoding recorded states gave a different stream" << std::endl;
+            return 1;
+        }
+
+        SpectatorDecoder decoder;
+        size_t offset = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (offset < stream.size()) {
+            size_t used = decoder.decode(stream.data() + offset, stream.size() - offset);
+            if (used == 0) {
+                std::cout << "decode failed at byte " << offset << std::endl;
+                return 1;
+            }
+            offset += used;
+        }
+        std::chrono::duration<double, std::nano> decodeTime = std::chrono::steady_clock::now() - start;
+
+        double bytesPerTick = (double)stats.bytes / ticks;
+        std::cout << (interval == 0 ? "new game" : std::to_string(interval)) << "  " << bytesPerTick << "  "
+            << stats.keyframes << "  " << bytesPerTick * 8 * tickRate / 1000 << "  "
+            << 100.0 * bytesPerTick / fullBytes << "%  " << encodeTime.count() / ticks << "  "
+            << decodeTime.count() / ticks << std::endl;
+    }
+    return 0;
+}
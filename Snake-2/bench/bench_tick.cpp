@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../core/game.h"
+#include "bench.h"
+
+// The snake runs round a Hamiltonian cycle of the board so it never dies, and
+// the cost per tick is reported for lengths from 3 up to a full board.
+int benchTick(int argc, char* argv[]) {
+    GameConfig config;
+    if (argc >= 3) {
+        config.width = atoi(argv[1]);
+        config.height = atoi(argv[2]);
+    }
+    if (config.width < 2 || config.height < 2 || config.height % 2 != 0) {
+        std::cout << "board needs width >= 2 and an even height >= 2" << std::endl;
+        return 1;
+    }
+
+    const std::vector<Point> cycle = hamiltonianCycle(config.width, config.height);
+    const int n = (int)cycle.size();
+    const int ticks = 2000000;
+
+    std::vector<int> lengths;
+    for (int length = config.initialLength; length < n; length *= 2) lengths.push_back(length);
+    lengths.push_back(n);
+
+    std::cout << "board " << config.width << "x" << config.height << std::endl;
+    std::cout << "length  ns/tick" << std::endl;
+
+    GameState game;
+    game.config = config;
+    for (int length : lengths) {
+        clearBoard(game);
+        for (int i = 0; i < length; i++) {
+            Point segment = cycle[length - 1 - i];
+            game.segments.pushBack(segment);
+            occupyCell(game, segment);
+        }
+        game.food = { -1, -1 }; // never eaten, so the length stays fixed
+
+        int k = length - 1;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; t++) {
+            int next = k + 1 == n ? 0 : k + 1;
+            game.direction = directionTo(cycle[k], cycle[next]);
+            k = next;
+            if (updateSnake(game) != STEP_MOVE) {
+                std::cout << "snake died during benchmark" << std::endl;
+                return 1;
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << length << "  " << elapsed.count() / ticks << std::endl;
+    }
+    return 0;
+}
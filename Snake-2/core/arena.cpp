@@ -0,0 +1,220 @@
+#include "arena.h"
+
+#include <algorithm>
+
+namespace {
+
+const uint32_t NO_TARGET = UINT32_MAX;
+const uint32_t NO_CELL = UINT32_MAX;
+
+enum ArenaOutcome : uint8_t { OUTCOME_MOVE, OUTCOME_EAT, OUTCOME_DIE };
+
+// Pulls every field into the range the arena can represent: snake ids must
+// fit the 16-bit owner grid and cell indices must stay below NO_CELL.
+ArenaConfig clampedConfig(ArenaConfig config) {
+    config.width = std::max(config.width, 1);
+    config.height = std::max(config.height, 1);
+    uint32_t maxHeight = (NO_CELL - 1) / (uint32_t)config.width;
+    if ((uint32_t)config.height > maxHeight) config.height = (int)maxHeight;
+    config.snakes = std::min(std::max(config.snakes, 0), ARENA_MAX_SNAKES);
+    config.initialLength = std::max(config.initialLength, 1);
+    config.maxLength = std::max(config.maxLength, config.initialLength);
+    config.food = std::max(config.food, 0);
+    config.respawnTicks = std::max(config.respawnTicks, 0);
+    return config;
+}
+
+} // namespace
+
+Arena::Arena(const ArenaConfig& config, uint64_t seed)
+    : arenaConfig(clampedConfig(config)),
+      snakeCount(arenaConfig.snakes),
+      width(arenaConfig.width),
+      height(arenaConfig.height),
+      cells((uint32_t)arenaConfig.width * arenaConfig.height),
+      rng(seed),
+      owners(cells),
+      foods(cells),
+      heads(snakeCount),
+      directions(snakeCount),
+      lengths(snakeCount),
+      bodyStart(snakeCount),
+      bodies(size_t(snakeCount) * arenaConfig.maxLength),
+      alives(snakeCount),
+      respawnAt(snakeCount),
+      targets(snakeCount),
+      outcomes(snakeCount) {
+    uint32_t claimSize = 16;
+    while (claimSize < 2 * (uint32_t)snakeCount) claimSize *= 2;
+    claims.resize(claimSize);
+    claimMask = claimSize - 1;
+    reset();
+}
+
+void Arena::reset() {
+    std::fill(owners.begin(), owners.end(), 0);
+    std::fill(foods.begin(), foods.end(), 0);
+    foodCount = 0;
+    counters = ArenaStats();
+    for (int i = 0; i < snakeCount; i++) {
+        alives[i] = 0;
+        respawnAt[i] = 0; // any snake that finds no room now tries again every tick
+        spawn(i);
+    }
+    topUpFood();
+}
+
+Point Arena::segment(int snake, int i) const {
+    uint32_t slot = bodyStart[snake] + i;
+    if (slot >= (uint32_t)arenaConfig.maxLength) slot -= arenaConfig.maxLength;
+    uint32_t cell = bodies[size_t(snake) * arenaConfig.maxLength + slot];
+    return { (int)(cell % width), (int)(cell / width) };
+}
+
+uint32_t Arena::tailSlot(int snake) const {
+    uint32_t slot = bodyStart[snake] + lengths[snake] - 1;
+    return slot >= (uint32_t)arenaConfig.maxLength ? slot - arenaConfig.maxLength : slot;
+}
+
+Arena::Claim& Arena::claimFor(uint32_t cell) {
+    uint32_t i = (uint32_t)((cell * 0x9E3779B97F4A7C15ull) >> 32) & claimMask;
+    while (claims[i].cell != cell && claims[i].cell != NO_CELL) i = (i + 1) & claimMask;
+    claims[i].cell = cell;
+    return claims[i];
+}
+
+void Arena::step(const uint8_t* actions) {
+    uint64_t tick = ++counters.ticks;
+    const uint32_t maxLength = (uint32_t)arenaConfig.maxLength;
+    std::fill(claims.begin(), claims.end(), Claim{ NO_CELL, 0, 0 });
+
+    // Where every head goes, and the longest snake aiming at each cell.
+    for (int i = 0; i < snakeCount; i++) {
+        targets[i] = NO_TARGET;
+        if (!alives[i]) continue;
+        Direction direction = Direction(actions[i] & 3);
+        if (direction == opposite(Direction(directions[i]))) direction = Direction(directions[i]);
+        directions[i] = (uint8_t)direction;
+
+        Point next = moved(head(i), direction);
+        if (!inside(next)) {
+            outcomes[i] = OUTCOME_DIE;
+            counters.wallDeaths++;
+            continue;
+        }
+        uint32_t cell = (uint32_t)cellIndex(next);
+        targets[i] = cell;
+        outcomes[i] = foods[cell] ? OUTCOME_EAT : OUTCOME_MOVE;
+        Claim& claim = claimFor(cell);
+        if (lengths[i] > claim.longest) {
+            claim.longest = lengths[i];
+            claim.count = 1;
+        }
+        else if (lengths[i] == claim.longest) {
+            claim.count++;
+        }
+    }
+
+    // Tails move out of the way before any head lands.
+    for (int i = 0; i < snakeCount; i++) {
+        if (targets[i] == NO_TARGET) continue;
+        if (outcomes[i] == OUTCOME_MOVE || lengths[i] == maxLength) {
+            owners[bodies[size_t(i) * maxLength + tailSlot(i)]] = 0;
+        }
+    }
+
+    for (int i = 0; i < snakeCount; i++) {
+        uint32_t cell = targets[i];
+        if (cell == NO_TARGET) continue;
+        const Claim& claim = claimFor(cell);
+        if (lengths[i] != claim.longest || claim.count != 1) {
+            outcomes[i] = OUTCOME_DIE;
+            counters.headDeaths++;
+        }
+        else if (owners[cell] != 0) {
+            outcomes[i] = OUTCOME_DIE;
+            counters.bodyDeaths++;
+        }
+    }
+
+    for (int i = 0; i < snakeCount; i++) {
+        if (!alives[i]) continue;
+        if (outcomes[i] == OUTCOME_DIE) {
+            removeSnake(i);
+            respawnAt[i] = tick + arenaConfig.respawnTicks;
+            continue;
+        }
+
+        uint32_t cell = targets[i];
+        bool grows = false;
+        if (outcomes[i] == OUTCOME_EAT) {
+            foods[cell] = 0;
+            foodCount--;
+            counters.foodEaten++;
+            grows = lengths[i] < maxLength;
+        }
+        uint32_t start = bodyStart[i] == 0 ? maxLength - 1 : bodyStart[i] - 1;
+        bodies[size_t(i) * maxLength + start] = cell; // at full length this overwrites the old tail
+        bodyStart[i] = start;
+        if (grows) lengths[i]++;
+        heads[i] = cell;
+        owners[cell] = (uint16_t)(i + 1);
+        counters.moves++;
+    }
+
+    for (int i = 0; i < snakeCount; i++) {
+        if (!alives[i] && respawnAt[i] <= tick && spawn(i)) counters.respawns++;
+    }
+    topUpFood();
+}
+
+// Lays the snake out straight behind a random head, facing away from its
+// tail, on cells with no snake or food. Gives up after a few tries.
+bool Arena::spawn(int snake) {
+    const int length = arenaConfig.initialLength;
+    uint32_t* body = &bodies[size_t(snake) * arenaConfig.maxLength];
+    for (int attempt = 0; attempt < 8; attempt++) {
+        Point p = { (int)rng.below((uint32_t)width), (int)rng.below((uint32_t)height) };
+        Direction direction = Direction(rng.below(4));
+        Direction back = opposite(direction);
+        int k = 0;
+        for (; k < length; k++) {
+            if (!inside(p) || owners[cellIndex(p)] != 0 || foods[cellIndex(p)] != 0) break;
+            body[k] = (uint32_t)cellIndex(p);
+            p = moved(p, back);
+        }
+        if (k < length) continue;
+
+        for (k = 0; k < length; k++) owners[body[k]] = (uint16_t)(snake + 1);
+        heads[snake] = body[0];
+        bodyStart[snake] = 0;
+        lengths[snake] = length;
+        directions[snake] = (uint8_t)direction;
+        alives[snake] = 1;
+        return true;
+    }
+    return false;
+}
+
+// Clears the snake's cells except any another head has already moved into.
+void Arena::removeSnake(int snake) {
+    const uint32_t maxLength = (uint32_t)arenaConfig.maxLength;
+    const uint32_t* body = &bodies[size_t(snake) * maxLength];
+    uint32_t slot = bodyStart[snake];
+    for (uint32_t k = 0; k < lengths[snake]; k++) {
+        uint32_t cell = body[slot];
+        if (owners[cell] == snake + 1) owners[cell] = 0;
+        if (++slot == maxLength) slot = 0;
+    }
+    alives[snake] = 0;
+}
+
+// Random probes; on a crowded board some food may wait for a later tick.
+void Arena::topUpFood() {
+    for (int attempt = 0; foodCount < arenaConfig.food && attempt < 4 * arenaConfig.food; attempt++) {
+        uint32_t cell = rng.below(cells);
+        if (owners[cell] != 0 || foods[cell] != 0) continue;
+        foods[cell] = 1;
+        foodCount++;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "point.h"
+#include "rng.h"
+
+// Arena mode: many snakes on one board, all moving at once. The board is an
+// owner grid (which snake covers each cell) plus a food grid, so every
+// collision check is one lookup whatever the snake count. Snake state is
+// stored structure-of-arrays like BatchEnv.
+//
+// A tick is resolved as if every snake moved at the same instant, and the
+// outcome never depends on snake order:
+//  - a snake that would leave the board dies where it is;
+//  - every other snake gives up its tail first, unless it is about to eat;
+//  - heads landing on the same cell: the one longest snake there survives,
+//    all of them die on a tie;
+//  - a head landing on any body left after that dies, own body included;
+//  - food under a surviving head is eaten and the snake grows by one.
+// Dead snakes leave the board at the end of the tick and respawn
+// `respawnTicks` later at a random free spot.
+struct ArenaConfig {
+    int width = 256;
+    int height = 256;
+    int snakes = 256;
+    int initialLength = 3;
+    int maxLength = 256;  // snakes stop growing here
+    int food = 256;       // food on the board, topped up every tick
+    int respawnTicks = 8;
+};
+
+// Most snakes one arena holds: the owner grid stores 16-bit ids.
+const int ARENA_MAX_SNAKES = 65535;
+
+struct ArenaStats {
+    uint64_t ticks = 0;
+    uint64_t moves = 0; // snake-ticks survived
+    uint64_t wallDeaths = 0;
+    uint64_t headDeaths = 0;
+    uint64_t bodyDeaths = 0;
+    uint64_t foodEaten = 0;
+    uint64_t respawns = 0;
+};
+
+class Arena {
+public:
+    // Out-of-range fields are clamped rather than rejected: at most
+    // ARENA_MAX_SNAKES snakes, maxLength at least initialLength, and a board
+    // whose cell indices fit 32 bits. config() returns what was used.
+    Arena(const ArenaConfig& config, uint64_t seed);
+
+    // Clears the board and spawns every snake again.
+    void reset();
+
+    // actions[i] is the Direction (as 0..3) requested for snake i; ignored
+    // for dead snakes, and a reversal keeps the current direction like turn().
+    void step(const uint8_t* actions);
+
+    int size() const { return snakeCount; }
+    const ArenaConfig& config() const { return arenaConfig; }
+    const ArenaStats& stats() const { return counters; }
+
+    bool alive(int snake) const { return alives[snake] != 0; }
+    int length(int snake) const { return lengths[snake]; }
+    Direction direction(int snake) const { return Direction(directions[snake]); }
+    Point head(int snake) const { return { (int)(heads[snake] % width), (int)(heads[snake] / width) }; }
+    // i = 0 is the head.
+    Point segment(int snake, int i) const;
+
+    // Snake covering the cell, or -1.
+    int owner(Point p) const { return (int)owners[cellIndex(p)] - 1; }
+    bool hasFood(Point p) const { return foods[cellIndex(p)] != 0; }
+    bool inside(Point p) const { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+
+private:
+    // Per-tick head claims, keyed by target cell. Open addressing over a table
+    // sized for every snake moving, so it stays far smaller than the board.
+    struct Claim {
+        uint32_t cell;
+        uint32_t longest;
+        uint32_t count; // snakes of length `longest` aiming here
+    };
+
+    size_t cellIndex(Point p) const { return (size_t)p.y * width + p.x; }
+    uint32_t tailSlot(int snake) const;
+    Claim& claimFor(uint32_t cell);
+    bool spawn(int snake);
+    void removeSnake(int snake);
+    void topUpFood();
+
+    ArenaConfig arenaConfig;
+    int snakeCount;
+    int width;
+    int height;
+    uint32_t cells;
+    Rng rng;
+    ArenaStats counters;
+
+    std::vector<uint16_t> owners; // per cell: snake + 1, 0 if free
+    std::vector<uint8_t> foods;   // per cell
+    int foodCount = 0;
+
+    std::vector<uint32_t> heads;     // head cell index
+    std::vector<uint8_t> directions;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> bodyStart; // ring slot holding the head
+    std::vector<uint32_t> bodies;    // `maxLength` ring slots per snake, head to tail
+    std::vector<uint8_t> alives;
+    std::vector<uint64_t> respawnAt; // tick a dead snake comes back
+
+    // Scratch for step().
+    std::vector<uint32_t> targets; // new head cell, or NO_TARGET
+    std::vector<uint8_t> outcomes; // ArenaOutcome
+    std::vector<Claim> claims;
+    uint32_t claimMask;
+};
@@ -0,0 +1,135 @@
+#include "asset_pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static const size_t HEADER_SIZE = 16;
+static const size_t INDEX_ENTRY_SIZE = 24;
+
+static void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((char)(value >> (8 * i)));
+}
+
+static void putU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back((char)(value >> (8 * i)));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t getU64(const uint8_t* p) {
+    return (uint64_t)getU32(p) | (uint64_t)getU32(p + 4) << 32;
+}
+
+bool writeAssetPack(const std::string& path, const std::vector<std::string>& names, const std::vector<std::string>& files) {
+    std::vector<size_t> order(names.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return names[a] < names[b]; });
+    // Lookups binary-search the names, which picks an arbitrary one of
+    // several equal entries.
+    for (size_t i = 1; i < order.size(); i++) {
+        if (names[order[i]] == names[order[i - 1]]) return false;
+    }
+
+    std::vector<std::string> contents(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        std::ifstream in(files[i], std::ios::binary);
+        if (!in) return false;
+        contents[i].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::string nameBlob;
+    for (size_t i : order) nameBlob += names[i];
+    size_t dataStart = HEADER_SIZE + names.size() * INDEX_ENTRY_SIZE + nameBlob.size();
+    dataStart = (dataStart + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+
+    std::string out(PACK_MAGIC, sizeof(PACK_MAGIC));
+    putU32(out, (uint32_t)names.size());
+    putU32(out, 0);
+    size_t dataOffset = dataStart;
+    size_t nameOffset = HEADER_SIZE + names.size() * INDEX_ENTRY_SIZE;
+    for (size_t i : order) {
+        putU64(out, dataOffset);
+        putU64(out, contents[i].size());
+        putU32(out, (uint32_t)nameOffset);
+        putU32(out, (uint32_t)names[i].size());
+        dataOffset += (contents[i].size() + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+        nameOffset += names[i].size();
+    }
+    out += nameBlob;
+    for (size_t i : order) {
+        out.resize((out.size() + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT, '\0');
+        out += contents[i];
+    }
+
+    std::ofstream pack(path, std::ios::binary | std::ios::trunc);
+    pack.write(out.data(), (std::streamsize)out.size());
+    return (bool)pack;
+}
+
+bool AssetPack::open(const char* path) {
+    close();
+    if (!file.open(path)) return false;
+
+    const uint8_t* bytes = file.data();
+    size_t length = file.size();
+    if (length < HEADER_SIZE || memcmp(bytes, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) {
+        close();
+        return false;
+    }
+    size_t count = getU32(bytes + 8);
+    if (count > (length - HEADER_SIZE) / INDEX_ENTRY_SIZE) {
+        close();
+        return false;
+    }
+    // Check every range once here so the accessors can trust the index.
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* e = bytes + HEADER_SIZE + i * INDEX_ENTRY_SIZE;
+        uint64_t dataOffset = getU64(e), dataSize = getU64(e + 8);
+        uint64_t nameOffset = getU32(e + 16), nameLength = getU32(e + 20);
+        if (dataOffset > length || dataSize > length - dataOffset ||
+            nameOffset > length || nameLength > length - nameOffset) {
+            close();
+            return false;
+        }
+    }
+    entryCount = count;
+    return true;
+}
+
+void AssetPack::close() {
+    file.close();
+    entryCount = 0;
+}
+
+const uint8_t* AssetPack::entry(size_t i) const {
+    return file.data() + HEADER_SIZE + i * INDEX_ENTRY_SIZE;
+}
+
+std::string_view AssetPack::name(size_t i) const {
+    const uint8_t* e = entry(i);
+    return std::string_view((const char*)file.data() + getU32(e + 16), getU32(e + 20));
+}
+
+const uint8_t* AssetPack::data(size_t i) const {
+    return file.data() + getU64(entry(i));
+}
+
+size_t AssetPack::size(size_t i) const {
+    return (size_t)getU64(entry(i) + 8);
+}
+
+long AssetPack::find(std::string_view key) const {
+    size_t low = 0, high = entryCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        std::string_view current = name(mid);
+        if (current == key) return (long)mid;
+        if (current < key) low = mid + 1;
+        else high = mid;
+    }
+    return -1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Single-file asset archive. Layout, all integers little-endian:
+//
+//   header   "SNKPACK1", uint32 entry count, uint32 reserved
+//   index    per entry: uint64 data offset, uint64 data size,
+//            uint32 name offset, uint32 name length
+//   names    concatenated, not NUL-terminated
+//   data     each blob starts on a PACK_ALIGNMENT boundary
+//
+// Entries are sorted by name so lookups are a binary search. Names are paths
+// relative to the packed directories' parent with '/' separators, e.g.
+// "img/apple.png", whatever OS built the pack.
+const char PACK_MAGIC[8] = { 'S', 'N', 'K', 'P', 'A', 'C', 'K', '1' };
+const size_t PACK_ALIGNMENT = 16;
+
+// Writes files[i] under names[i]. Returns false if two names are the same,
+// a file can't be read or the pack can't be written.
+bool writeAssetPack(const std::string& path, const std::vector<std::string>& names, const std::vector<std::string>& files);
+
+// Memory-mapped pack. Entry data points straight into the mapping and stays
+// valid until close().
+class AssetPack {
+public:
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    size_t count() const { return entryCount; }
+    std::string_view name(size_t i) const;
+    const uint8_t* data(size_t i) const;
+    size_t size(size_t i) const;
+
+    // Index of the entry with this name, or -1.
+    long find(std::string_view name) const;
+
+private:
+    const uint8_t* entry(size_t i) const;
+
+    MappedFile file;
+    size_t entryCount = 0;
+};
@@ -0,0 +1,185 @@
+#include "batch_env.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+int popcount64(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(x);
+#elif defined(_MSC_VER)
+    return (int)(__popcnt((unsigned)x) + __popcnt((unsigned)(x >> 32)));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// At least two cells, so a fresh game always has somewhere for food, and a
+// starting snake that fits the height and leaves a cell free.
+GameConfig clampedConfig(GameConfig config) {
+    if (config.width < 1) config.width = 1;
+    if (config.height < 1) config.height = 1;
+    if (config.width * config.height < 2) config.height = 2;
+    if (config.initialLength > config.height) config.initialLength = config.height;
+    if (config.initialLength > config.width * config.height - 1) config.initialLength = config.width * config.height - 1;
+    if (config.initialLength < 1) config.initialLength = 1;
+    return config;
+}
+
+} // namespace
+
+BatchEnv::BatchEnv(int gameCount, const GameConfig& config, uint64_t seed)
+    : boardConfig(clampedConfig(config)),
+      gameCount(gameCount > 0 ? gameCount : 0),
+      width(boardConfig.width),
+      cells(boardConfig.width * boardConfig.height),
+      words((cells + 63) / 64),
+      heads(this->gameCount),
+      foods(this->gameCount),
+      directions(this->gameCount),
+      lengths(this->gameCount),
+      bodyStart(this->gameCount),
+      bodies(size_t(this->gameCount) * cells),
+      occupancy(size_t(this->gameCount) * words),
+      rngState(this->gameCount) {
+    for (int i = 0; i < this->gameCount; i++) {
+        rngState[i] = splitmix64(seed); // decorrelated per-game streams
+    }
+    reset();
+}
+
+void BatchEnv::reset() {
+    for (int i = 0; i < gameCount; i++) resetGame(i);
+}
+
+bool BatchEnv::occupied(int game, int x, int y) const {
+    int cell = y * width + x;
+    return (occupancy[size_t(game) * words + cell / 64] >> (cell % 64)) & 1;
+}
+
+uint64_t BatchEnv::nextRandom(int game) {
+    return splitmix64(rngState[game]);
+}
+
+void BatchEnv::resetGame(int game) {
+    uint64_t* bits = &occupancy[size_t(game) * words];
+    uint32_t* body = &bodies[size_t(game) * cells];
+    for (int w = 0; w < words; w++) bits[w] = 0;
+
+    int height = boardConfig.height;
+    int length = boardConfig.initialLength;
+    int headY = height / 2;
+    if (headY + length > height) headY = height - length;
+    for (int i = 0; i < length; i++) {
+        uint32_t cell = (headY + i) * width + width / 2;
+        body[i] = cell;
+        bits[cell / 64] |= 1ull << (cell % 64);
+    }
+
+    heads[game] = body[0];
+    bodyStart[game] = 0;
+    lengths[game] = length;
+    directions[game] = (uint8_t)Direction::UP;
+    placeFood(game);
+}
+
+// A few random probes find a free cell almost always; when the snake covers
+// most of the board, pick the k-th free cell from the bitboard instead.
+// Returns false, leaving the food where it was, when there is no free cell.
+bool BatchEnv::placeFood(int game) {
+    if (lengths[game] >= (uint32_t)cells) return false;
+    const uint64_t* bits = &occupancy[size_t(game) * words];
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t cell = (uint32_t)(nextRandom(game) % cells);
+        if (!((bits[cell / 64] >> (cell % 64)) & 1)) {
+            foods[game] = cell;
+            return true;
+        }
+    }
+
+    int k = (int)(nextRandom(game) % (cells - lengths[game]));
+    for (int w = 0; w < words; w++) {
+        uint64_t freeBits = ~bits[w];
+        if (w == words - 1 && cells % 64 != 0) freeBits &= (1ull << (cells % 64)) - 1;
+        int n = popcount64(freeBits);
+        if (k < n) {
+            while (k-- > 0) freeBits &= freeBits - 1;
+            int bit = 0;
+            while (!((freeBits >> bit) & 1)) bit++;
+            foods[game] = w * 64 + bit;
+            return true;
+        }
+        k -= n;
+    }
+    return false;
+}
+
+void BatchEnv::step(const uint8_t* actions, uint8_t* results) {
+    step(actions, results, 0, gameCount);
+}
+
+void BatchEnv::step(const uint8_t* actions, uint8_t* results, int begin, int end) {
+    const int height = boardConfig.height;
+
+    for (int i = begin; i < end; i++) {
+        Direction current = Direction(directions[i]);
+        Direction requested = Direction(actions[i] & 3);
+        if (requested != opposite(current)) {
+            directions[i] = (uint8_t)requested;
+            current = requested;
+        }
+
+        int x = heads[i] % width;
+        int y = heads[i] / width;
+        switch (current) {
+        case Direction::UP: y--; break;
+        case Direction::DOWN: y++; break;
+        case Direction::LEFT: x--; break;
+        case Direction::RIGHT: x++; break;
+        }
+
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            results[i] = STEP_CRASH_WALL;
+            resetGame(i);
+            continue;
+        }
+
+        uint32_t cell = y * width + x;
+        uint64_t* bits = &occupancy[size_t(i) * words];
+        uint32_t* body = &bodies[size_t(i) * cells];
+        bool eating = cell == foods[i];
+
+        if (!eating) {
+            uint32_t tailSlot = bodyStart[i] + lengths[i] - 1;
+            if (tailSlot >= (uint32_t)cells) tailSlot -= cells;
+            uint32_t tail = body[tailSlot];
+            if (((bits[cell / 64] >> (cell % 64)) & 1) && cell != tail) {
+                results[i] = STEP_CRASH_SELF;
+                resetGame(i);
+                continue;
+            }
+            bits[tail / 64] &= ~(1ull << (tail % 64));
+            lengths[i]--;
+        }
+
+        uint32_t start = bodyStart[i] == 0 ? cells - 1 : bodyStart[i] - 1;
+        body[start] = cell;
+        bodyStart[i] = start;
+        bits[cell / 64] |= 1ull << (cell % 64);
+        heads[i] = cell;
+        lengths[i]++;
+
+        if (!eating) {
+            results[i] = STEP_MOVE;
+        }
+        else if (!placeFood(i)) {
+            results[i] = STEP_BOARD_FULL;
+            resetGame(i);
+        }
+        else {
+            results[i] = STEP_EAT;
+        }
+    }
+}
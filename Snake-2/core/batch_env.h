@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+#include "rng.h"
+
+// Many games on the same board size, stepped together for agent training.
+// State is stored structure-of-arrays (one array per field, indexed by game)
+// and each game's occupancy is a bitboard, so stepping N games touches a few
+// contiguous arrays instead of N GameState objects. Rules match updateSnake().
+class BatchEnv {
+public:
+    // The config is clamped to a board of at least two cells and a starting
+    // snake of 1..height that leaves a cell free; config() returns what was
+    // used.
+    BatchEnv(int gameCount, const GameConfig& config, uint64_t seed);
+
+    // Starts every game again, like initializeGame().
+    void reset();
+
+    // actions[i] is the Direction (as 0..3) requested for game i; results[i]
+    // receives its StepResult. Games that end are reset straight away, so
+    // after the call every game is ready for the next step.
+    void step(const uint8_t* actions, uint8_t* results);
+
+    // Same as step() for games [begin, end) only. Disjoint ranges may be
+    // stepped from different threads.
+    void step(const uint8_t* actions, uint8_t* results, int begin, int end);
+
+    int size() const { return gameCount; }
+    const GameConfig& config() const { return boardConfig; }
+
+    int headX(int game) const { return heads[game] % width; }
+    int headY(int game) const { return heads[game] / width; }
+    int foodX(int game) const { return foods[game] % width; }
+    int foodY(int game) const { return foods[game] / width; }
+    Direction direction(int game) const { return Direction(directions[game]); }
+    int length(int game) const { return lengths[game]; }
+    bool occupied(int game, int x, int y) const;
+
+private:
+    void resetGame(int game);
+    bool placeFood(int game);
+    uint64_t nextRandom(int game);
+
+    GameConfig boardConfig;
+    int gameCount;
+    int width;
+    int cells;
+    int words; // 64-bit occupancy words per game
+
+    std::vector<uint32_t> heads;     // head cell index
+    std::vector<uint32_t> foods;     // food cell index
+    std::vector<uint8_t> directions;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> bodyStart; // ring slot holding the head
+    std::vector<uint32_t> bodies;    // `cells` ring slots per game, head to tail
+    std::vector<uint64_t> occupancy; // `words` bitboard words per game
+    std::vector<uint64_t> rngState;  // splitmix64, one stream per game
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "point.h"
+
+// One byte per board cell, non-zero while a snake segment covers it. Updated
+// on every head push / tail pop so collision and food checks are one lookup.
+class Occupancy {
+public:
+    void reset(int newWidth, int newHeight) {
+        width = newWidth;
+        cells.assign(size_t(newWidth) * newHeight, 0);
+    }
+
+    bool test(Point p) const { return cells[index(p)] != 0; }
+    void set(Point p) { cells[index(p)] = 1; }
+    void clear(Point p) { cells[index(p)] = 0; }
+
+    // Sizes the board without clearing it, for a caller about to write
+    // every cell through setCell().
+    void resize(int newWidth, int newHeight) {
+        width = newWidth;
+        cells.resize(size_t(newWidth) * newHeight);
+    }
+    void setCell(int cell, bool taken) { cells[cell] = taken; }
+
+private:
+    size_t index(Point p) const { return size_t(p.y) * width + p.x; }
+
+    std::vector<unsigned char> cells;
+    int width = 0;
+};
+
+// Cells not covered by the snake, as a dense array plus each cell's position in
+// it. Removing a cell swaps the last free cell into its slot, so add, remove
+// and picking a uniformly random free cell are all O(1).
+class FreeCells {
+public:
+    void reset(int cellCount) {
+        cells.resize(cellCount);
+        position.resize(cellCount);
+        for (int i = 0; i < cellCount; i++) {
+            cells[i] = i;
+            position[i] = i;
+        }
+        count = cellCount;
+    }
+
+    void add(int cell) {
+        int other = cells[count];
+        cells[count] = cell;
+        cells[position[cell]] = other;
+        position[other] = position[cell];
+        position[cell] = count;
+        count++;
+    }
+
+    void remove(int cell) {
+        count--;
+        int other = cells[count];
+        cells[count] = cell;
+        cells[position[cell]] = other;
+        position[other] = position[cell];
+        position[cell] = count;
+    }
+
+    int size() const { return count; }
+    // i may go past size() to read the taken cells too; their order decides
+    // where later add() calls put things, so snapshots keep all of it.
+    int operator[](int i) const { return cells[i]; }
+    // All of it at once, for copying out.
+    const int* order() const { return cells.data(); }
+
+    // Restores a whole order as read back through operator[], and rebuilds
+    // the occupancy in the same pass: the cells after the free ones are the
+    // taken ones.
+    template <typename Cell>
+    void assign(const Cell* order, int cellCount, int freeCount, Occupancy& occupied) {
+        cells.resize(cellCount);
+        position.resize(cellCount);
+        for (int i = 0; i < cellCount; i++) {
+            cells[i] = order[i];
+            position[order[i]] = i;
+            occupied.setCell(order[i], i >= freeCount);
+        }
+        count = freeCount;
+    }
+
+private:
+    std::vector<int> cells;    // cells[0..count) are free, the rest are taken
+    std::vector<int> position; // index of each cell in cells
+    int count = 0;
+};
@@ -0,0 +1,80 @@
+#include "chunked_occupancy.h"
+
+#include <algorithm>
+#include <cstring>
+
+void ChunkedOccupancy::reset(int, int) {
+    for (const auto& entry : index) release(entry.second);
+    index.clear();
+}
+
+uint32_t ChunkedOccupancy::take() {
+    if (freeChunks.empty()) {
+        size_t slab = 0;
+        while (slab < slabs.size() && slabs[slab]) slab++;
+        if (slab == slabs.size()) {
+            slabs.emplace_back();
+            slabUsed.push_back(0);
+        }
+        slabs[slab].reset(new OccupancyChunk[SLAB_CHUNKS]);
+        liveSlabs++;
+        emptySlabs++;
+        uint32_t first = (uint32_t)(slab * SLAB_CHUNKS);
+        for (int i = SLAB_CHUNKS - 1; i >= 0; i--) freeChunks.push_back(first + i);
+    }
+    uint32_t id = freeChunks.back();
+    freeChunks.pop_back();
+    if (slabUsed[id / SLAB_CHUNKS]++ == 0) emptySlabs--;
+    memset(&chunk(id), 0, sizeof(OccupancyChunk));
+    return id;
+}
+
+void ChunkedOccupancy::release(uint32_t id) {
+    freeChunks.push_back(id);
+    uint32_t slab = id / SLAB_CHUNKS;
+    if (--slabUsed[slab] > 0) return;
+    if (emptySlabs == 0) {
+        emptySlabs++; // kept as the spare
+        return;
+    }
+    // Its chunks are somewhere in the pool; take them all out. The scan
+    // covers the whole pool, but only runs when a second slab empties.
+    uint32_t first = slab * SLAB_CHUNKS;
+    freeChunks.erase(std::remove_if(freeChunks.begin(), freeChunks.end(),
+        [first](uint32_t chunkId) { return chunkId - first < (uint32_t)SLAB_CHUNKS; }), freeChunks.end());
+    slabs[slab].reset();
+    liveSlabs--;
+}
+
+const OccupancyChunk* ChunkedOccupancy::find(Point p) const {
+    auto it = index.find(key(p));
+    return it == index.end() ? nullptr : &chunk(it->second);
+}
+
+void ChunkedOccupancy::set(Point p) {
+    auto inserted = index.emplace(key(p), 0);
+    if (inserted.second) inserted.first->second = take();
+
+    OccupancyChunk& target = chunk(inserted.first->second);
+    uint64_t& row = target.rows[p.y & (CHUNK_SIDE - 1)];
+    uint64_t bit = 1ull << (p.x & (CHUNK_SIDE - 1));
+    if ((row & bit) == 0) {
+        row |= bit;
+        target.count++;
+    }
+}
+
+void ChunkedOccupancy::clear(Point p) {
+    auto it = index.find(key(p));
+    if (it == index.end()) return;
+
+    OccupancyChunk& target = chunk(it->second);
+    uint64_t& row = target.rows[p.y & (CHUNK_SIDE - 1)];
+    uint64_t bit = 1ull << (p.x & (CHUNK_SIDE - 1));
+    if ((row & bit) == 0) return;
+    row &= ~bit;
+    if (--target.count == 0) {
+        release(it->second);
+        index.erase(it);
+    }
+}
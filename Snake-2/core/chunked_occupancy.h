@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "point.h"
+
+// Occupancy for boards far too large for a byte per cell. The board is cut
+// into 64 x 64 chunks, one bit per cell; a chunk exists only while some cell
+// in it is set, so memory follows the snake rather than the board. Emptied
+// chunks go back to a pool and are handed out again before any new memory is
+// allocated, and once every chunk of a slab is back in the pool the slab is
+// freed, keeping one empty slab around so a snake crossing a slab boundary
+// back and forth does not allocate every time. Same interface as Occupancy.
+const int CHUNK_SHIFT = 6;
+const int CHUNK_SIDE = 1 << CHUNK_SHIFT;
+
+struct OccupancyChunk {
+    uint64_t rows[CHUNK_SIDE]; // bit x of rows[y]
+    uint32_t count;            // set cells
+};
+
+class ChunkedOccupancy {
+public:
+    // Clears the board. Chunks in use go back to the pool. The size is only
+    // taken for Occupancy's sake: chunks are keyed by position, not laid out.
+    void reset(int width, int height);
+
+    bool test(Point p) const {
+        const OccupancyChunk* chunk = find(p);
+        return chunk != nullptr && (chunk->rows[p.y & (CHUNK_SIDE - 1)] >> (p.x & (CHUNK_SIDE - 1)) & 1) != 0;
+    }
+    void set(Point p);
+    void clear(Point p);
+
+    size_t chunks() const { return index.size(); }
+    size_t pooledChunks() const { return freeChunks.size(); }
+    // Chunk memory held now, in use or pooled.
+    size_t chunkBytes() const { return liveSlabs * SLAB_CHUNKS * sizeof(OccupancyChunk); }
+
+private:
+    // Chunks are allocated SLAB_CHUNKS at a time so they never move.
+    static const int SLAB_CHUNKS = 256;
+
+    static uint64_t key(Point p) {
+        return (uint64_t)(uint32_t)(p.y >> CHUNK_SHIFT) << 32 | (uint32_t)(p.x >> CHUNK_SHIFT);
+    }
+    const OccupancyChunk* find(Point p) const;
+    uint32_t take();
+    void release(uint32_t id);
+    OccupancyChunk& chunk(uint32_t id) { return slabs[id / SLAB_CHUNKS][id % SLAB_CHUNKS]; }
+    const OccupancyChunk& chunk(uint32_t id) const { return slabs[id / SLAB_CHUNKS][id % SLAB_CHUNKS]; }
+
+    std::unordered_map<uint64_t, uint32_t> index; // chunk key -> chunk id
+    std::vector<std::unique_ptr<OccupancyChunk[]>> slabs; // null once freed, reused by the next slab
+    std::vector<uint32_t> slabUsed;                      // chunks in use per slab
+    std::vector<uint32_t> freeChunks;
+    size_t liveSlabs = 0;
+    size_t emptySlabs = 0; // allocated slabs with nothing in use
+};
@@ -0,0 +1,54 @@
+#include "game.h"
+
+#include "game_rules.h"
+
+void newGame(GameState& game, const GameConfig& config, uint64_t seed) {
+    // A snake longer than the board is tall would start above it.
+    GameConfig clamped = config;
+    if (clamped.width < 1) clamped.width = 1;
+    if (clamped.height < 1) clamped.height = 1;
+    if (clamped.initialLength > clamped.height) clamped.initialLength = clamped.height;
+    if (clamped.initialLength < 1) clamped.initialLength = 1;
+    newGameRules(game, clamped, seed);
+}
+
+void clearBoard(GameState& game) {
+    int cells = game.config.width * game.config.height;
+    game.segments.reset(cells);
+    game.occupied.reset(game.config.width, game.config.height);
+    game.freeCells.reset(cells);
+}
+
+void occupyCell(GameState& game, Point p) {
+    game.occupied.set(p);
+    game.freeCells.remove(p.y * game.config.width + p.x);
+}
+
+void vacateCell(GameState& game, Point p) {
+    game.occupied.clear(p);
+    game.freeCells.add(p.y * game.config.width + p.x);
+}
+
+bool placeFood(GameState& game) {
+    if (game.freeCells.size() == 0) return false;
+
+    int cell = game.freeCells[game.rng.below(game.freeCells.size())];
+    game.food.x = cell % game.config.width;
+    game.food.y = cell / game.config.width;
+    return true;
+}
+
+// The ring is sized to the whole board by clearBoard(), so there is always room.
+static void makeRoomForHead(GameState&) {}
+
+void initializeGame(GameState& game) {
+    initializeGameRules(game);
+}
+
+void turn(GameState& game, Direction direction) {
+    turnRules(game, direction);
+}
+
+int updateSnake(GameState& game) {
+    return updateSnakeRules(game);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+#include "board.h"
+#include "point.h"
+#include "rng.h"
+#include "snake_body.h"
+
+// SDL-free game rules. The front end in main.cpp and the headless tools all
+// drive a GameState through initializeGame() / step() / updateSnake().
+
+struct GameConfig {
+    int width = 16;  // cells
+    int height = 12; // cells
+    int initialLength = 3;
+};
+
+// updateSnake() results. The numeric values are the codes the game has always
+// used, so 1/2/3 keep meaning wall crash / eat / self crash.
+enum StepResult {
+    STEP_MOVE = 0,
+    STEP_CRASH_WALL = 1,
+    STEP_EAT = 2,
+    STEP_CRASH_SELF = 3,
+    STEP_BOARD_FULL = 4,
+};
+
+struct GameState {
+    GameConfig config;
+    SnakeBody segments; // head first
+    Occupancy occupied;
+    FreeCells freeCells;
+    Direction direction = Direction::UP;
+    Point food = { 0, 0 };
+    Rng rng;
+    uint64_t tick = 0; // updateSnake() calls since newGame(), across restarts
+};
+
+inline bool isGameOver(int result) {
+    return result == STEP_CRASH_WALL || result == STEP_CRASH_SELF || result == STEP_BOARD_FULL;
+}
+
+// Sets the board size and seed, then starts the first game. Sides below 1
+// become 1 and initialLength is clamped to 1..height; game.config holds
+// what was used.
+void newGame(GameState& game, const GameConfig& config, uint64_t seed);
+
+// Puts a fresh snake in the middle of the board and places food. The RNG
+// carries on from where it was, so a whole session replays from one seed.
+void initializeGame(GameState& game);
+
+// Empties the board without placing a snake or food.
+void clearBoard(GameState& game);
+
+void occupyCell(GameState& game, Point p);
+void vacateCell(GameState& game, Point p);
+
+// Returns false when the snake covers the whole board and there is nowhere left to put food.
+bool placeFood(GameState& game);
+
+// Turns the snake unless that would reverse it onto its own neck.
+void turn(GameState& game, Direction direction);
+
+// Advances one tick. On a crash the state is left as it was before the move;
+// the caller decides when to call initializeGame().
+int updateSnake(GameState& game);
+
+inline int step(GameState& game, Direction action) {
+    turn(game, action);
+    return updateSnake(game);
+}
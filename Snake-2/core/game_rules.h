@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game.h"
+
+// The rules behind newGame() / initializeGame() / turn() / updateSnake(),
+// written once for every board representation. A Game needs the members
+// GameState has for them (config, segments, occupied with test(Point),
+// direction, food, rng, tick) and these functions, found for it by
+// argument-dependent lookup:
+//
+//   void clearBoard(Game&)               empty board, no snake or food
+//   void occupyCell(Game&, Point)        a segment now covers the cell
+//   void vacateCell(Game&, Point)        the tail left the cell
+//   bool placeFood(Game&)                false when the board is full
+//   void makeRoomForHead(Game&)          before the snake grows by one
+//
+// Only game.cpp and sparse_game.cpp include this; everything else calls
+// their overloads.
+
+template <typename Game>
+void newGameRules(Game& game, const GameConfig& config, uint64_t seed) {
+    game.config = config;
+    game.rng.seed(seed);
+    game.tick = 0;
+    initializeGame(game);
+}
+
+template <typename Game>
+void initializeGameRules(Game& game) {
+    clearBoard(game);
+
+    // Tail hangs down from the middle of the board, moved up if it would not fit.
+    int headY = game.config.height / 2;
+    if (headY + game.config.initialLength > game.config.height) headY = game.config.height - game.config.initialLength;
+    for (int i = 0; i < game.config.initialLength; i++) {
+        Point segment = { game.config.width / 2, headY + i };
+        game.segments.pushBack(segment);
+        occupyCell(game, segment);
+    }
+
+    game.direction = Direction::UP;
+    placeFood(game);
+}
+
+template <typename Game>
+void turnRules(Game& game, Direction direction) {
+    if (direction != opposite(game.direction)) {
+        game.direction = direction;
+    }
+}
+
+template <typename Game>
+int updateSnakeRules(Game& game) {
+    game.tick++;
+    Point newHead = moved(game.segments.front(), game.direction);
+
+    // Crashing the wall
+    if (newHead.x < 0 || newHead.x >= game.config.width || newHead.y < 0 || newHead.y >= game.config.height) {
+        return STEP_CRASH_WALL;
+    }
+
+    // Eating food or keep moving
+    if (newHead == game.food) {
+        makeRoomForHead(game);
+        game.segments.pushFront(newHead);
+        occupyCell(game, newHead);
+        if (!placeFood(game)) return STEP_BOARD_FULL;
+        return STEP_EAT;
+    }
+
+    // If snake crashing on it self. The tail moves out of the way this tick,
+    // so running into the cell it leaves is fine.
+    Point tail = game.segments.back();
+    if (game.occupied.test(newHead) && newHead != tail) {
+        return STEP_CRASH_SELF;
+    }
+
+    vacateCell(game, tail);
+    game.segments.popBack();
+    game.segments.pushFront(newHead);
+    occupyCell(game, newHead);
+
+    return STEP_MOVE;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "point.h"
+
+// Direction presses waiting for the next ticks, oldest first. Each press is
+// checked against the last direction already queued (not the direction the
+// snake has now), so "up, left" typed within one tick becomes two turns
+// instead of a reversal into the snake's own neck. One press is consumed per
+// tick; presses that arrive while the queue is full are dropped.
+class InputQueue {
+public:
+    static const int CAPACITY = 4;
+
+    struct Entry {
+        Direction direction;
+        uint64_t timestamp; // caller's clock, for latency measurements
+    };
+
+    void clear() { count = 0; }
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+
+    // `current` is the snake's direction, used when nothing is queued yet.
+    // Returns false if the press was a reversal, a repeat, or did not fit.
+    bool push(Direction direction, Direction current, uint64_t timestamp) {
+        Direction last = count > 0 ? entries[(first + count - 1) % CAPACITY].direction : current;
+        if (direction == last || direction == opposite(last) || count == CAPACITY) return false;
+        entries[(first + count) % CAPACITY] = { direction, timestamp };
+        count++;
+        return true;
+    }
+
+    bool pop(Entry& entry) {
+        if (count == 0) return false;
+        entry = entries[first];
+        first = (first + 1) % CAPACITY;
+        count--;
+        return true;
+    }
+
+private:
+    Entry entries[CAPACITY];
+    int first = 0;
+    int count = 0;
+};
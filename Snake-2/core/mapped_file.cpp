@@ -0,0 +1,76 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path) {
+    close();
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    // The mapping keeps the file open, so the handle can go right away.
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return false;
+
+    bytes = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (bytes == nullptr) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    length = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) UnmapViewOfFile(bytes);
+    if (mapping != nullptr) CloseHandle(mapping);
+    bytes = nullptr;
+    mapping = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+
+    bytes = (const uint8_t*)view;
+    length = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) munmap((void*)bytes, length);
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. Pages are loaded on first touch
+// and shared with the OS file cache, so reading never copies into a buffer
+// of our own.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+struct Point {
+    int x, y;
+};
+
+inline bool operator==(Point a, Point b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(Point a, Point b) { return !(a == b); }
+
+enum class Direction { UP, DOWN, LEFT, RIGHT };
+
+inline Direction opposite(Direction direction) {
+    switch (direction) {
+    case Direction::UP: return Direction::DOWN;
+    case Direction::DOWN: return Direction::UP;
+    case Direction::LEFT: return Direction::RIGHT;
+    default: return Direction::LEFT;
+    }
+}
+
+inline Point moved(Point p, Direction direction) {
+    switch (direction) {
+    case Direction::UP:
+        p.y -= 1;
+        break;
+    case Direction::DOWN:
+        p.y += 1;
+        break;
+    case Direction::LEFT:
+        p.x -= 1;
+        break;
+    case Direction::RIGHT:
+        p.x += 1;
+        break;
+    }
+    return p;
+}
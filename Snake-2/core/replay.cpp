@@ -0,0 +1,136 @@
+#include "replay.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char REPLAY_MAGIC[4] = { 'S', 'N', 'K', 'R' };
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+void ReplayRecorder::start(const GameConfig& config, uint64_t seed) {
+    data.assign(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    data.push_back(REPLAY_VERSION);
+    putVarint(data, (uint64_t)config.width);
+    putVarint(data, (uint64_t)config.height);
+    putVarint(data, (uint64_t)config.initialLength);
+    for (int i = 0; i < 8; i++) data.push_back((uint8_t)(seed >> (8 * i)));
+    tickCount = 0;
+    lastTurn = 0;
+    finished = false;
+}
+
+void ReplayRecorder::tick(Direction heading, Direction direction) {
+    if (finished) return;
+    if (direction != heading) {
+        putVarint(data, (tickCount - lastTurn + 1) << 2 | (uint64_t)direction);
+        lastTurn = tickCount + 1;
+    }
+    tickCount++;
+}
+
+void ReplayRecorder::finish() {
+    if (finished) return;
+    data.push_back(0);
+    putVarint(data, tickCount - lastTurn);
+    finished = true;
+}
+
+bool ReplayRecorder::save(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool ReplayReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) return false;
+        uint8_t byte = *cursor++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// Loads the next record: a turn some ticks ahead, or the end marker with the
+// number of ticks left.
+bool ReplayReader::readTurn() {
+    uint64_t value;
+    if (!readVarint(value)) return false;
+    if (value == 0) {
+        turnPending = false;
+        return readVarint(ticksToTurn);
+    }
+    if ((value >> 2) == 0) return false;
+    turnPending = true;
+    ticksToTurn = (value >> 2) - 1;
+    turnDirection = Direction(value & 3);
+    return true;
+}
+
+bool ReplayReader::open(const uint8_t* bytes, size_t size) {
+    cursor = bytes;
+    end = bytes + size;
+    ended = false;
+    failed = true;
+    if (size < sizeof(REPLAY_MAGIC) + 1 || memcmp(bytes, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) return false;
+    cursor += sizeof(REPLAY_MAGIC);
+    if (*cursor++ != REPLAY_VERSION) return false;
+
+    uint64_t width, height, initialLength;
+    if (!readVarint(width) || !readVarint(height) || !readVarint(initialLength)) return false;
+    if (width == 0 || height == 0 || width > 4096 || height > 4096 || initialLength == 0 || initialLength > height) return false;
+    gameConfig.width = (int)width;
+    gameConfig.height = (int)height;
+    gameConfig.initialLength = (int)initialLength;
+
+    if (end - cursor < 8) return false;
+    gameSeed = 0;
+    for (int i = 0; i < 8; i++) gameSeed |= (uint64_t)cursor[i] << (8 * i);
+    cursor += 8;
+
+    failed = !readTurn();
+    return !failed;
+}
+
+bool ReplayReader::next(bool& turns, Direction& direction) {
+    if (failed || ended) return false;
+    if (ticksToTurn > 0) {
+        ticksToTurn--;
+        turns = false;
+        return true;
+    }
+    if (!turnPending) {
+        ended = true;
+        return false;
+    }
+    turns = true;
+    direction = turnDirection;
+    // This tick is used up by the turn, so the next record's count starts
+    // from the tick after it.
+    failed = !readTurn();
+    return true;
+}
+
+bool ReplayPlayer::open(const uint8_t* bytes, size_t size) {
+    if (!replay.open(bytes, size)) return false;
+    newGame(game, replay.config(), replay.seed());
+    return true;
+}
+
+int ReplayPlayer::step() {
+    bool turns;
+    Direction direction;
+    if (!replay.next(turns, direction)) return -1;
+    if (turns) turn(game, direction);
+    int result = updateSnake(game);
+    if (isGameOver(result)) initializeGame(game);
+    return result;
+}
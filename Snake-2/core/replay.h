@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// Recorded session: the seed plus every tick on which the snake changed
+// direction. Food placement comes from the seeded Rng, so re-running
+// updateSnake() with the same turns reproduces the session exactly,
+// including every game after the first.
+//
+// Layout: "SNKR", version byte, varint width, height and initial length,
+// 8-byte little-endian seed, then one varint per turn holding
+// ((straight ticks since the previous turn + 1) << 2 | direction). A 0 ends the turns and
+// is followed by a varint of the ticks played after the last turn. Varints
+// are LEB128: 7 bits per byte, low bits first, high bit set on all but the
+// last byte. A straight run of any length costs a couple of bytes.
+const uint8_t REPLAY_VERSION = 1;
+
+class ReplayRecorder {
+public:
+    void start(const GameConfig& config, uint64_t seed);
+
+    // Once per tick, just before updateSnake(). `heading` is the direction
+    // the snake had coming into the tick (after initializeGame() on the
+    // first tick of a game), `direction` the one it moves in now.
+    void tick(Direction heading, Direction direction);
+
+    // Ends the recording; bytes() is then a complete replay.
+    void finish();
+
+    const std::vector<uint8_t>& bytes() const { return data; }
+    uint64_t ticks() const { return tickCount; }
+
+    bool save(const char* path) const;
+
+private:
+    std::vector<uint8_t> data;
+    uint64_t tickCount = 0;
+    uint64_t lastTurn = 0; // first tick after the previous turn
+    bool finished = false;
+};
+
+// Reads turns back tick by tick. Does not copy the data, which must outlive
+// the reader.
+class ReplayReader {
+public:
+    bool open(const uint8_t* bytes, size_t size);
+
+    const GameConfig& config() const { return gameConfig; }
+    uint64_t seed() const { return gameSeed; }
+
+    // Advances one tick. Returns false once the recording is over; otherwise
+    // sets `turns` and, if true, the direction to turn() to before this
+    // tick's updateSnake().
+    bool next(bool& turns, Direction& direction);
+
+    // True once next() has read a proper end marker, false if the data ran
+    // out or was malformed.
+    bool complete() const { return ended; }
+
+private:
+    bool readVarint(uint64_t& value);
+    bool readTurn();
+
+    const uint8_t* cursor = nullptr;
+    const uint8_t* end = nullptr;
+    GameConfig gameConfig;
+    uint64_t gameSeed = 0;
+    uint64_t ticksToTurn = 0; // ticks before the pending turn (or the end)
+    Direction turnDirection = Direction::UP;
+    bool turnPending = false; // false: ticksToTurn counts down to the end
+    bool ended = false;
+    bool failed = false;
+};
+
+// Re-simulates a recording headlessly, starting a new game after every game
+// over the way the front end does.
+class ReplayPlayer {
+public:
+    // Starts the first game. The data must outlive the player.
+    bool open(const uint8_t* bytes, size_t size);
+
+    // One tick: returns its StepResult, or -1 once the recording is over.
+    int step();
+
+    const GameState& state() const { return game; }
+    const ReplayReader& reader() const { return replay; }
+
+private:
+    ReplayReader replay;
+    GameState game;
+};
@@ -0,0 +1,56 @@
+#include "replay_analysis.h"
+
+#include "replay.h"
+
+void ReplayColumns::clear() {
+    replay.clear();
+    game.clear();
+    ticks.clear();
+    finalLength.clear();
+    cause.clear();
+    curveBegin.assign(1, 0);
+    curveTicks.clear();
+}
+
+void ReplayColumns::append(const ReplayColumns& other) {
+    replay.insert(replay.end(), other.replay.begin(), other.replay.end());
+    game.insert(game.end(), other.game.begin(), other.game.end());
+    ticks.insert(ticks.end(), other.ticks.begin(), other.ticks.end());
+    finalLength.insert(finalLength.end(), other.finalLength.begin(), other.finalLength.end());
+    cause.insert(cause.end(), other.cause.begin(), other.cause.end());
+    uint64_t offset = curveTicks.size();
+    for (size_t i = 1; i < other.curveBegin.size(); i++) curveBegin.push_back(other.curveBegin[i] + offset);
+    curveTicks.insert(curveTicks.end(), other.curveTicks.begin(), other.curveTicks.end());
+}
+
+bool analyzeReplay(const uint8_t* bytes, size_t size, uint32_t replayIndex, ReplayColumns& out) {
+    ReplayPlayer player;
+    if (!player.open(bytes, size)) return false;
+
+    uint32_t gameNumber = 0;
+    uint32_t tick = 0;
+    uint32_t length = (uint32_t)player.state().segments.size();
+    auto endGame = [&](uint8_t cause) {
+        out.replay.push_back(replayIndex);
+        out.game.push_back(gameNumber++);
+        out.ticks.push_back(tick);
+        out.finalLength.push_back(length);
+        out.cause.push_back(cause);
+        out.curveBegin.push_back(out.curveTicks.size());
+        tick = 0;
+    };
+
+    for (int result = player.step(); result != -1; result = player.step()) {
+        tick++;
+        if (result == STEP_EAT || result == STEP_BOARD_FULL) {
+            length++;
+            out.curveTicks.push_back(tick);
+        }
+        if (isGameOver(result)) {
+            endGame((uint8_t)result);
+            length = (uint32_t)player.state().segments.size();
+        }
+    }
+    if (tick > 0) endGame(0);
+    return player.reader().complete();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-game results of re-simulating replays, stored column by column: row i
+// of every column describes the same game. A replay holds a whole session,
+// so one replay usually adds several rows.
+struct ReplayColumns {
+    std::vector<uint32_t> replay;      // index of the replay the game came from
+    std::vector<uint32_t> game;        // game number within its replay
+    std::vector<uint32_t> ticks;       // ticks the game lasted
+    std::vector<uint32_t> finalLength; // snake length when it ended
+    std::vector<uint8_t> cause;        // StepResult that ended it, 0 if the session stopped first
+
+    // Length curve, CSR style: the ticks (within the game) at which game i's
+    // snake ate are curveTicks[curveBegin[i] .. curveBegin[i + 1]).
+    std::vector<uint64_t> curveBegin{ 0 };
+    std::vector<uint32_t> curveTicks;
+
+    size_t rows() const { return ticks.size(); }
+    void clear();
+    // Appends other's rows, offsetting curve indices to match.
+    void append(const ReplayColumns& other);
+};
+
+// Re-simulates one replay and appends a row per game, tagged with
+// replayIndex. Returns false if the replay is malformed or truncated; rows
+// for the games played before the damage are still appended.
+bool analyzeReplay(const uint8_t* bytes, size_t size, uint32_t replayIndex, ReplayColumns& out);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Step of the splitmix64 generator. Used to expand a 64-bit seed into
+// xoshiro state, and on its own where a game needs only 8 bytes of RNG state.
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** (Blackman & Vigna). Same sequence on every platform for a
+// given seed, cheap to copy, and jump() skips 2^128 outputs so one seed can
+// be split into non-overlapping streams for threads.
+class Rng {
+public:
+    Rng() { seed(0); }
+    explicit Rng(uint64_t value) { seed(value); }
+
+    void seed(uint64_t value) {
+        uint64_t sm = value;
+        for (uint64_t& word : s) word = splitmix64(sm);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n) for n > 0, by scaling the top 32 bits.
+    uint32_t below(uint32_t n) {
+        return (uint32_t)(((next() >> 32) * n) >> 32);
+    }
+
+    // Advances the state by 2^128 calls to next().
+    void jump() {
+        static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+        uint64_t t[4] = { 0, 0, 0, 0 };
+        for (uint64_t jump : JUMP) {
+            for (int b = 0; b < 64; b++) {
+                if (jump & (1ull << b)) {
+                    for (int i = 0; i < 4; i++) t[i] ^= s[i];
+                }
+                next();
+            }
+        }
+        for (int i = 0; i < 4; i++) s[i] = t[i];
+    }
+
+    uint64_t s[4];
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
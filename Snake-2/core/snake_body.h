@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "point.h"
+
+// Snake body kept head-to-tail in a ring buffer sized to the whole board, so a
+// move is an O(1) head push plus tail pop instead of shifting every segment.
+// Storage is only allocated by reset() and grow(); pushes never reallocate.
+class SnakeBody {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const SnakeBody* body, size_t index) : body(body), index(index) {}
+        const Point& operator*() const { return (*body)[index]; }
+        const Point* operator->() const { return &(*body)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+    private:
+        const SnakeBody* body;
+        size_t index;
+    };
+
+    void reset(size_t newCapacity) {
+        if (buffer.size() < newCapacity) buffer.resize(newCapacity);
+        capacity = newCapacity;
+        head = 0;
+        count = 0;
+    }
+
+    // Moves the body into a larger ring, for boards too big to size it up
+    // front.
+    void grow(size_t newCapacity) {
+        std::vector<Point> larger(newCapacity);
+        for (size_t i = 0; i < count; i++) larger[i] = (*this)[i];
+        buffer.swap(larger);
+        capacity = newCapacity;
+        head = 0;
+    }
+
+    void pushFront(Point p) {
+        head = (head == 0 ? capacity : head) - 1;
+        buffer[head] = p;
+        count++;
+    }
+
+    void pushBack(Point p) {
+        count++;
+        buffer[slot(count - 1)] = p;
+    }
+
+    void popBack() { count--; }
+
+    // Replaces the body with points[0..n), head first. Anything with x and y
+    // members will do, e.g. a snapshot's packed points.
+    template <typename P>
+    void assign(const P* points, size_t n) {
+        for (size_t i = 0; i < n; i++) buffer[i] = { points[i].x, points[i].y };
+        head = 0;
+        count = n;
+    }
+
+    // Calls f(point) head to tail, walking the ring as two plain runs.
+    template <typename F>
+    void forEach(F f) const {
+        size_t firstRun = capacity - head < count ? capacity - head : count;
+        const Point* run = buffer.data() + head;
+        for (size_t i = 0; i < firstRun; i++) f(run[i]);
+        for (size_t i = 0; i < count - firstRun; i++) f(buffer[i]);
+    }
+
+    const Point& front() const { return buffer[head]; }
+    const Point& back() const { return buffer[slot(count - 1)]; }
+    const Point& operator[](size_t i) const { return buffer[slot(i)]; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == capacity; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+
+private:
+    size_t slot(size_t i) const {
+        size_t j = head + i;
+        return j >= capacity ? j - capacity : j;
+    }
+
+    std::vector<Point> buffer;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t count = 0;
+};
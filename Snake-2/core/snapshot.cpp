@@ -0,0 +1,59 @@
+#include "snapshot.h"
+
+bool saveSnapshot(const GameState& game, GameSnapshot& snapshot) {
+    const int width = game.config.width;
+    const int cells = width * game.config.height;
+    if (cells > SNAPSHOT_MAX_CELLS) return false;
+
+    snapshot.config = game.config;
+    snapshot.tick = game.tick;
+    for (int i = 0; i < 4; i++) snapshot.rng[i] = game.rng.s[i];
+    snapshot.food = game.food;
+    snapshot.direction = game.direction;
+    snapshot.length = (uint16_t)game.segments.size();
+    snapshot.freeCount = (uint16_t)game.freeCells.size();
+    SnapshotPoint* body = snapshot.body;
+    game.segments.forEach([&](Point p) { *body++ = { (uint16_t)p.x, (uint16_t)p.y }; });
+    const int* order = game.freeCells.order();
+    for (int c = 0; c < cells; c++) snapshot.cellOrder[c] = (uint16_t)order[c];
+    return true;
+}
+
+void restoreSnapshot(GameState& game, const GameSnapshot& snapshot) {
+    const int width = snapshot.config.width;
+    const int cells = width * snapshot.config.height;
+
+    game.config = snapshot.config;
+    game.tick = snapshot.tick;
+    for (int i = 0; i < 4; i++) game.rng.s[i] = snapshot.rng[i];
+    game.food = snapshot.food;
+    game.direction = snapshot.direction;
+
+    game.segments.reset(cells);
+    game.segments.assign(snapshot.body, snapshot.length);
+    game.occupied.resize(width, snapshot.config.height);
+    game.freeCells.assign(snapshot.cellOrder, cells, snapshot.freeCount, game.occupied);
+}
+
+SnapshotRing::SnapshotRing(int capacity) : slots(capacity < 1 ? 1 : capacity) {}
+
+bool SnapshotRing::push(const GameState& game) {
+    if (game.config.width * game.config.height > SNAPSHOT_MAX_CELLS) return false;
+
+    int slot = (first + count) % (int)slots.size();
+    if (count < (int)slots.size()) count++;
+    else first = (first + 1) % (int)slots.size(); // overwrite the oldest
+    return saveSnapshot(game, slots[slot]);
+}
+
+bool SnapshotRing::rollback(GameState& game, uint64_t tick) {
+    for (int i = count - 1; i >= 0; i--) {
+        const GameSnapshot& snapshot = (*this)[i];
+        if (snapshot.tick <= tick) {
+            restoreSnapshot(game, snapshot);
+            count = i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "game.h"
+
+// Largest board a snapshot can hold, e.g. 32 x 32.
+const int SNAPSHOT_MAX_CELLS = 1024;
+
+struct SnapshotPoint {
+    uint16_t x, y;
+};
+
+// Everything needed to continue a game exactly, in one flat struct that can
+// be memcpy'd, stored in arrays or sent over the wire as-is. Occupancy is not
+// stored since it follows from the body. The free cell order is, in full:
+// placeFood() indexes into it, so a rebuilt order would place food
+// elsewhere.
+struct GameSnapshot {
+    GameConfig config;
+    uint64_t tick;
+    uint64_t rng[4];
+    Point food;
+    Direction direction;
+    uint16_t length;
+    uint16_t freeCount;
+    SnapshotPoint body[SNAPSHOT_MAX_CELLS]; // head first; x/y, not cell index, so restore needs no divides
+    uint16_t cellOrder[SNAPSHOT_MAX_CELLS]; // FreeCells order, free cells first
+};
+
+static_assert(std::is_trivially_copyable<GameSnapshot>::value, "GameSnapshot must stay memcpy-able");
+
+// Returns false if the board has more than SNAPSHOT_MAX_CELLS cells.
+bool saveSnapshot(const GameState& game, GameSnapshot& snapshot);
+
+// Puts the game back exactly as it was when saved. Only allocates if the
+// game had never been set up for a board this size.
+void restoreSnapshot(GameState& game, const GameSnapshot& snapshot);
+
+// The last few snapshots of one game, oldest overwritten first, for going
+// back to an earlier tick without replaying from the start.
+class SnapshotRing {
+public:
+    explicit SnapshotRing(int capacity);
+
+    // Saves the game as the newest snapshot.
+    bool push(const GameState& game);
+
+    // Restores the newest snapshot taken at or before `tick` and forgets it
+    // and the ones after it: re-simulating from there pushes them again.
+    // False (and the game untouched) if none is that old.
+    bool rollback(GameState& game, uint64_t tick);
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+    int capacity() const { return (int)slots.size(); }
+    // i = 0 is the oldest kept snapshot.
+    const GameSnapshot& operator[](int i) const { return slots[(first + i) % slots.size()]; }
+
+private:
+    std::vector<GameSnapshot> slots;
+    int first = 0;
+    int count = 0;
+};
@@ -0,0 +1,89 @@
+#include "sparse_game.h"
+
+#include "game_rules.h"
+
+// First ring size; grow() doubles it as the snake gets longer.
+static const size_t INITIAL_BODY_CAPACITY = 1024;
+
+static uint64_t cellCount(const GameConfig& config) {
+    return (uint64_t)config.width * (uint64_t)config.height;
+}
+
+static int clampedTo(int value, int low, int high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+void newGame(SparseGame& game, const GameConfig& config, uint64_t seed) {
+    // Past SPARSE_MAX_SIDE the chunk keys and the uint32_t food probes stop
+    // covering the board, and a snake longer than the board is tall would
+    // start above it.
+    GameConfig clamped = config;
+    clamped.width = clampedTo(config.width, 1, SPARSE_MAX_SIDE);
+    clamped.height = clampedTo(config.height, 1, SPARSE_MAX_SIDE);
+    clamped.initialLength = clampedTo(config.initialLength, 1, clamped.height);
+    newGameRules(game, clamped, seed);
+}
+
+void clearBoard(SparseGame& game) {
+    // Room for the starting snake at least: initializeGame() lays it out
+    // without going through makeRoomForHead().
+    uint64_t cells = cellCount(game.config);
+    uint64_t capacity = INITIAL_BODY_CAPACITY;
+    if ((uint64_t)game.config.initialLength > capacity) capacity = (uint64_t)game.config.initialLength;
+    game.segments.reset((size_t)(cells < capacity ? cells : capacity));
+    game.occupied.reset(game.config.width, game.config.height);
+}
+
+// A handful of probes almost always lands on a free cell, since the snake
+// covers a tiny part of a big board. When it does not, walk on from the
+// last probe to the next free cell: at most the snake's length steps.
+bool placeFood(SparseGame& game) {
+    const uint64_t cells = cellCount(game.config);
+    if (game.segments.size() >= cells) return false;
+
+    Point p = { 0, 0 };
+    for (int attempt = 0; attempt < 16; attempt++) {
+        p.x = (int)game.rng.below((uint32_t)game.config.width);
+        p.y = (int)game.rng.below((uint32_t)game.config.height);
+        if (!game.occupied.test(p)) {
+            game.food = p;
+            return true;
+        }
+    }
+    while (game.occupied.test(p)) {
+        if (++p.x == game.config.width) {
+            p.x = 0;
+            if (++p.y == game.config.height) p.y = 0;
+        }
+    }
+    game.food = p;
+    return true;
+}
+
+static void occupyCell(SparseGame& game, Point p) {
+    game.occupied.set(p);
+}
+
+static void vacateCell(SparseGame& game, Point p) {
+    game.occupied.clear(p);
+}
+
+// Doubles the ring when the snake is about to outgrow it.
+static void makeRoomForHead(SparseGame& game) {
+    if (!game.segments.full()) return;
+    uint64_t cells = cellCount(game.config);
+    uint64_t capacity = (uint64_t)game.segments.size() * 2;
+    game.segments.grow((size_t)(capacity < cells ? capacity : cells));
+}
+
+void initializeGame(SparseGame& game) {
+    initializeGameRules(game);
+}
+
+void turn(SparseGame& game, Direction direction) {
+    turnRules(game, direction);
+}
+
+int updateSnake(SparseGame& game) {
+    return updateSnakeRules(game);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chunked_occupancy.h"
+#include "game.h"
+
+// The game rules on boards up to SPARSE_MAX_SIDE cells a side. GameState
+// keeps a byte and a free-list slot per cell, which stops working long before
+// that; here occupancy is chunked and the body ring grows with the snake, so
+// memory follows the snake's length, not the board's area.
+//
+// The rules are GameState's, shared through game_rules.h. Food is placed differently: random probes
+// instead of a pick from a free cell list, so the same seed gives a
+// different game than on a GameState board.
+const int SPARSE_MAX_SIDE = 1 << 20;
+
+struct SparseGame {
+    GameConfig config;
+    SnakeBody segments; // head first
+    ChunkedOccupancy occupied;
+    Direction direction = Direction::UP;
+    Point food = { 0, 0 };
+    Rng rng;
+    uint64_t tick = 0;
+};
+
+// Sides are clamped to 1..SPARSE_MAX_SIDE and initialLength to the height;
+// game.config holds what was used.
+void newGame(SparseGame& game, const GameConfig& config, uint64_t seed);
+void initializeGame(SparseGame& game);
+
+// Empties the board; keeps the body ring and pooled chunks for reuse.
+void clearBoard(SparseGame& game);
+
+// Returns false when the snake covers the whole board.
+bool placeFood(SparseGame& game);
+
+void turn(SparseGame& game, Direction direction);
+int updateSnake(SparseGame& game);
+
+inline int step(SparseGame& game, Direction action) {
+    turn(game, action);
+    return updateSnake(game);
+}
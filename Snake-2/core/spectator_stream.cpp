@@ -0,0 +1,210 @@
+#include "spectator_stream.h"
+
+static const uint8_t FRAME_KEY = 0x80;
+static const uint8_t FRAME_TAIL_POPPED = 0x04;
+static const uint8_t FRAME_FOOD = 0x08;
+static const uint8_t FRAME_STILL = 0x10;
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// Returns the bytes used, or 0 if the varint runs past `end` or is too long.
+static size_t getVarint(const uint8_t* cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < 10 && cursor + i < end; i++) {
+        value |= (uint64_t)(cursor[i] & 0x7F) << (7 * i);
+        if ((cursor[i] & 0x80) == 0) return i + 1;
+    }
+    return 0;
+}
+
+static Direction stepDirection(Point from, Point to) {
+    if (to.x > from.x) return Direction::RIGHT;
+    if (to.x < from.x) return Direction::LEFT;
+    if (to.y > from.y) return Direction::DOWN;
+    return Direction::UP;
+}
+
+size_t SpectatorEncoder::encode(const GameState& game, std::vector<uint8_t>& out) {
+    if (keyframeInterval > 0 && sinceKeyframe + 1 >= keyframeInterval) synced = false;
+    if (!synced || game.config.width != width || game.config.height != height) return encodeKeyframe(game, out);
+
+    // A tick either leaves the snake where it was, or moves the head one step
+    // with the tail following or staying put. Anything else is a new game.
+    const SnakeBody& segments = game.segments;
+    size_t length = body.size();
+    uint8_t frame;
+    if (segments.size() == length && segments.front() == body.front() && segments.back() == body.back()) {
+        frame = FRAME_STILL;
+    }
+    else {
+        Point head = moved(body.front(), game.direction);
+        if (segments.front() != head) return encodeKeyframe(game, out);
+        if (segments.size() == length && segments.back() == (length >= 2 ? body[length - 2] : head)) {
+            frame = FRAME_TAIL_POPPED;
+            body.popBack();
+        }
+        else if (segments.size() == length + 1 && segments.back() == body.back()) {
+            frame = 0;
+        }
+        else {
+            return encodeKeyframe(game, out);
+        }
+        frame |= (uint8_t)game.direction;
+        body.pushFront(head);
+    }
+
+    size_t before = out.size();
+    if (game.food != food) {
+        out.push_back(frame | FRAME_FOOD);
+        putVarint(out, (uint64_t)game.food.y * width + game.food.x);
+        food = game.food;
+    }
+    else {
+        out.push_back(frame);
+    }
+    size_t size = out.size() - before;
+    sinceKeyframe++;
+    counters.frames++;
+    counters.bytes += size;
+    return size;
+}
+
+size_t SpectatorEncoder::encodeKeyframe(const GameState& game, std::vector<uint8_t>& out) {
+    size_t before = out.size();
+    const SnakeBody& segments = game.segments;
+    width = game.config.width;
+    height = game.config.height;
+    food = game.food;
+
+    out.push_back(FRAME_KEY | (uint8_t)game.direction);
+    putVarint(out, (uint64_t)width);
+    putVarint(out, (uint64_t)height);
+    putVarint(out, (uint64_t)food.y * width + food.x);
+    putVarint(out, (uint64_t)segments.size());
+    putVarint(out, (uint64_t)segments.front().y * width + segments.front().x);
+
+    body.reset((size_t)width * height);
+    body.pushBack(segments.front());
+    uint8_t packed = 0;
+    int steps = 0;
+    for (size_t i = 1; i < segments.size(); i++) {
+        packed |= (uint8_t)stepDirection(segments[i - 1], segments[i]) << (2 * steps);
+        body.pushBack(segments[i]);
+        if (++steps == 4) {
+            out.push_back(packed);
+            packed = 0;
+            steps = 0;
+        }
+    }
+    if (steps > 0) out.push_back(packed);
+
+    size_t size = out.size() - before;
+    synced = true;
+    sinceKeyframe = 0;
+    counters.frames++;
+    counters.keyframes++;
+    counters.bytes += size;
+    counters.keyframeBytes += size;
+    return size;
+}
+
+size_t SpectatorDecoder::decode(const uint8_t* bytes, size_t size) {
+    if (size == 0) return 0;
+    uint8_t frame = bytes[0];
+    if (frame & FRAME_KEY) return decodeKeyframe(bytes, size);
+    if (!synced) return 0;
+
+    // Read the whole frame before touching the state, so a short one
+    // changes nothing.
+    size_t used = 1;
+    Point newFood = game.food;
+    if (frame & FRAME_FOOD) {
+        uint64_t cell;
+        size_t n = getVarint(bytes + 1, bytes + size, cell);
+        if (n == 0 || cell >= (uint64_t)game.config.width * game.config.height) return 0;
+        newFood = { (int)(cell % game.config.width), (int)(cell / game.config.width) };
+        used += n;
+    }
+
+    lastKeyframe = false;
+    lastGrew = false;
+    lastOldTail = game.segments.back();
+    if (frame & FRAME_STILL) {
+        lastMoved = false;
+        game.food = newFood;
+        return used;
+    }
+
+    Direction direction = Direction(frame & 3);
+    Point head = moved(game.segments.front(), direction);
+    bool popped = (frame & FRAME_TAIL_POPPED) != 0;
+    if (head.x < 0 || head.x >= game.config.width || head.y < 0 || head.y >= game.config.height ||
+        (!popped && game.segments.full())) {
+        synced = false;
+        return 0;
+    }
+    if (popped) {
+        vacateCell(game, lastOldTail);
+        game.segments.popBack();
+    }
+    if (game.occupied.test(head)) {
+        synced = false;
+        return 0;
+    }
+    game.segments.pushFront(head);
+    occupyCell(game, head);
+    game.direction = direction;
+    game.food = newFood;
+    lastMoved = true;
+    lastGrew = !popped;
+    return used;
+}
+
+size_t SpectatorDecoder::decodeKeyframe(const uint8_t* bytes, size_t size) {
+    const uint8_t* cursor = bytes + 1;
+    const uint8_t* end = bytes + size;
+    uint64_t values[5]; // width, height, food, length, head
+    for (uint64_t& value : values) {
+        size_t n = getVarint(cursor, end, value);
+        if (n == 0) return 0;
+        cursor += n;
+    }
+    uint64_t width = values[0], height = values[1], foodCell = values[2], length = values[3], headCell = values[4];
+    if (width == 0 || height == 0 || width > SPECTATOR_MAX_SIDE || height > SPECTATOR_MAX_SIDE) return 0;
+    uint64_t cells = width * height;
+    if (foodCell >= cells || length == 0 || length > cells || headCell >= cells) return 0;
+    size_t stepBytes = (size_t)(length - 1 + 3) / 4;
+    if ((size_t)(end - cursor) < stepBytes) return 0;
+
+    synced = false;
+    game.config.width = (int)width;
+    game.config.height = (int)height;
+    clearBoard(game);
+    Point segment = { (int)(headCell % width), (int)(headCell / width) };
+    game.segments.pushBack(segment);
+    occupyCell(game, segment);
+    for (uint64_t i = 1; i < length; i++) {
+        uint64_t step = i - 1;
+        segment = moved(segment, Direction((cursor[step / 4] >> (2 * (step % 4))) & 3));
+        if (segment.x < 0 || segment.x >= (int)width || segment.y < 0 || segment.y >= (int)height ||
+            game.occupied.test(segment)) {
+            return 0;
+        }
+        game.segments.pushBack(segment);
+        occupyCell(game, segment);
+    }
+    game.food = { (int)(foodCell % width), (int)(foodCell / width) };
+    game.direction = Direction(bytes[0] & 3);
+    synced = true;
+    lastKeyframe = true;
+    lastMoved = false;
+    lastGrew = false;
+    lastOldTail = game.segments.back();
+    return (size_t)(cursor - bytes) + stepBytes;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// Live view of a game for spectators: one frame per tick, each either a
+// keyframe holding the whole snake or a delta holding only what the tick
+// changed. Unlike a replay it needs no simulation on the receiving end and no
+// shared seed, so a spectator can start from any keyframe.
+//
+// Delta: one byte, bit 7 clear. Bits 0-1 are the direction the head moved,
+// bit 2 is set if the tail was popped (clear when the snake grew), bit 3 is
+// set if a varint food cell (y * width + x) follows, bit 4 is set instead of
+// everything else on a tick where nothing moved. A plain move is one byte.
+//
+// Keyframe: one byte 0x80 | direction, then varints width, height, food cell,
+// length and head cell, then the body as 2-bit steps from each segment to the
+// next towards the tail, four to a byte, low bits first.
+//
+// Frames carry no length or tick number; they are meant for an ordered,
+// reliable channel or a file. Any gap needs the next keyframe.
+const int SPECTATOR_MAX_SIDE = 4096;
+
+struct SpectatorStats {
+    uint64_t frames = 0;
+    uint64_t keyframes = 0;
+    uint64_t bytes = 0;
+    uint64_t keyframeBytes = 0;
+};
+
+class SpectatorEncoder {
+public:
+    // 0 sends keyframes only when a delta cannot describe the tick (the first
+    // frame, a new game); otherwise also at least every `interval` frames so
+    // spectators can join mid-game.
+    explicit SpectatorEncoder(int keyframeInterval = 0) : keyframeInterval(keyframeInterval) {}
+
+    // Appends the frame taking spectators from the last encoded state to
+    // `game`. Call once per tick, after updateSnake() and any
+    // initializeGame() that followed it. Returns the frame's size.
+    size_t encode(const GameState& game, std::vector<uint8_t>& out);
+
+    // Makes the next frame a keyframe, e.g. when a spectator joins.
+    void requestKeyframe() { synced = false; }
+
+    const SpectatorStats& stats() const { return counters; }
+
+private:
+    size_t encodeKeyframe(const GameState& game, std::vector<uint8_t>& out);
+
+    int keyframeInterval;
+    bool synced = false;
+    int sinceKeyframe = 0;
+    SnakeBody body; // what spectators have, to tell a move from a new game
+    Point food = { 0, 0 };
+    int width = 0;
+    int height = 0;
+    SpectatorStats counters;
+};
+
+// Rebuilds the game from frames. Only the snake, occupancy, food and
+// direction are kept up to date; the Rng and free cell order are not, so the
+// state is for drawing, not for stepping.
+class SpectatorDecoder {
+public:
+    // Applies the frame at the start of `bytes`. Returns the bytes it used,
+    // or 0 if the frame is cut short, malformed, or a delta with no keyframe
+    // before it.
+    size_t decode(const uint8_t* bytes, size_t size);
+
+    bool ready() const { return synced; }
+    const GameState& state() const { return game; }
+
+    // How the last frame changed the snake, for drawing in-between frames.
+    bool keyframe() const { return lastKeyframe; }
+    bool snakeMoved() const { return lastMoved; }
+    bool grew() const { return lastGrew; }
+    Point oldTail() const { return lastOldTail; }
+
+private:
+    size_t decodeKeyframe(const uint8_t* bytes, size_t size);
+
+    GameState game;
+    bool synced = false;
+    bool lastKeyframe = false;
+    bool lastMoved = false;
+    bool lastGrew = false;
+    Point lastOldTail = { 0, 0 };
+};
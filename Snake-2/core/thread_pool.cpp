@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; i++) queues.emplace_back(new Queue());
+    for (int i = 1; i < threadCount; i++) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int, int)>& fn) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+
+    int chunks = (end - begin + grain - 1) / grain;
+    int workers = size();
+    if (workers == 1) {
+        for (int c = begin; c < end; c += grain) fn(c, c + grain < end ? c + grain : end, 0);
+        return;
+    }
+
+    job = &fn;
+    pending.store(chunks);
+    for (int c = 0; c < chunks; c++) {
+        int chunkBegin = begin + c * grain;
+        int chunkEnd = chunkBegin + grain < end ? chunkBegin + grain : end;
+        Queue& queue = *queues[(long long)c * workers / chunks];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.push_back({ chunkBegin, chunkEnd });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!runOne(0)) std::this_thread::yield();
+    }
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!runOne(index)) std::this_thread::yield();
+        }
+    }
+}
+
+bool ThreadPool::runOne(int index) {
+    Range range;
+    bool found = false;
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            found = true;
+        }
+    }
+
+    int workers = size();
+    for (int k = 1; k < workers && !found; k++) {
+        Queue& victim = *queues[(index + k) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+    (*job)(range.begin, range.end, index);
+    pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
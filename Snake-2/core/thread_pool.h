@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers for running independent games in parallel. Work is cut
+// into chunks and dealt out in contiguous blocks, one deque per worker; a
+// worker takes its own chunks newest-first and, once it runs dry, steals the
+// oldest chunk from another worker. The thread calling parallelFor() is
+// worker 0 and helps until the whole range is done.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)queues.size(); }
+
+    // Runs fn(chunkBegin, chunkEnd, worker) over [begin, end) in chunks of at
+    // most `grain` items and returns when every chunk has finished. `worker`
+    // is in [0, size()) and can index per-thread state such as RNG streams.
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int, int)>& fn);
+
+private:
+    struct Range {
+        int begin, end;
+    };
+
+    // Padded so workers locking their own queue do not share cache lines.
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void workerLoop(int index);
+    bool runOne(int index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    const std::function<void(int, int, int)>* job = nullptr;
+
+    // Chunks not yet finished; decremented once per chunk, not per item.
+    alignas(64) std::atomic<int> pending{ 0 };
+
+    alignas(64) std::mutex wakeMutex;
+    std::condition_variable wake;
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
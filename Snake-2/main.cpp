@@ -1,201 +1,305 @@
+#include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <SDL.h>
 #include<SDL_image.h>
 #include <SDL_mixer.h>
 
+#include "core/asset_pack.h"
+#include "core/game.h"
+#include "core/input_queue.h"
+#include "core/replay.h"
+#include "core/spectator_stream.h"
+#include "asset_loader.h"
+#include "sprite_atlas.h"
+#include "sound_effects.h"
+#include "sprite_batch.h"
+
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 const int GRID_SIZE = 40;
 const int INITIAL_SNAKE_LENGTH = 3;
-const int timeDelay = 130;
+const int timeDelay = 130; // default ms per simulation tick
+const int GAME_OVER_PAUSE_MS = 2000;
+const char* const ASSET_PACK = "assets.pak"; // built by SnakePack from img/ and sfx/
+const char* const ATLAS_CACHE = "sprites.cache"; // packed atlas in the renderer's pixel format
+
+// Every image in img/ is packed into one atlas texture. A frame is drawn as a
+// single SpriteBatch, or with one SDL_RenderCopy per sprite on the legacy path.
+enum Sprite { SPRITE_HEAD, SPRITE_BODY, SPRITE_FOOD, SPRITE_COUNT };
+const char* const spriteNames[SPRITE_COUNT] = { "snake_head", "snake_body", "apple" };
+SpriteAtlas spriteAtlas;
+SDL_Rect spriteRects[SPRITE_COUNT];
+SpriteBatch spriteBatch;
+bool batchedRendering = true;
+
+// CPU time spent building and submitting frames (not presenting them).
+struct FrameStats {
+    Uint64 frames = 0;
+    Uint64 drawCalls = 0;
+    double totalMs = 0;
+};
 
-SDL_Texture* snakeHeadTexture = NULL;
-SDL_Texture* snakeBodyTexture = NULL;
-SDL_Texture* foodTexture = NULL;
+FrameStats frameStats;
 
 SDL_Window* gWindow = NULL;
 SDL_Renderer* gRenderer = NULL;
 SDL_Event e;
 
-Mix_Music* bite;
-Mix_Music* crashWall;
-Mix_Music* crashSelf;
-
-struct Point {
-    int x, y;
-};
+SoundEffects soundEffects;
+AudioSettings audioSettings;
 
-enum class Direction { UP, DOWN, LEFT, RIGHT };
+InputQueue inputQueue;
 
-struct Snake {
-    std::vector<Point> segments;
-    Direction direction;
-    SDL_Texture* headTexture;
-    SDL_Texture* bodyTexture;
+// Input-to-move latency: time from a key press to the tick that turns the snake.
+struct LatencyStats {
+    Uint64 moves = 0;
+    Uint64 totalMs = 0;
+    Uint32 maxMs = 0;
 };
 
-Point food;
-
-SDL_Texture* loadTexture(const char* filename, SDL_Renderer *renderer)
-{
-    /*SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
-        "Loading %s", filename);
-
-    SDL_Texture* texture = IMG_LoadTexture(renderer, filename);
-    if (texture == NULL) {
-        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
-            "Load texture %s", IMG_GetError());
-    }*/
-
-    SDL_Texture* texture = NULL;
-    SDL_Surface* load_surface = IMG_Load(filename);
-    if (load_surface != NULL)
-    {
-        texture = SDL_CreateTextureFromSurface(gRenderer, load_surface);
-        if (texture == NULL) {
-            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
-                "Load texture %s", IMG_GetError());
-        }
-    }
-
-    return texture;
-}
-
-void placeFood(Snake& snake) {
-    bool onSnake = true;
+LatencyStats inputLatency;
 
-    while (onSnake) {
-        food.x = rand() % (SCREEN_WIDTH / GRID_SIZE);
-        food.y = rand() % (SCREEN_HEIGHT / GRID_SIZE);
-
-        onSnake = false;
-        for (const auto& segment : snake.segments) {
-            if (food.x == segment.x && food.y == segment.y) {
-                onSnake = true;
-                break;
-            }
-        }
-    }
-}
-
-void initializeGame(Snake& snake) {
-    snake.segments.clear();
-    snake.headTexture = snakeHeadTexture;
-    snake.bodyTexture = snakeBodyTexture;
-
-    for (int i = 0; i < INITIAL_SNAKE_LENGTH; i++) {
-        snake.segments.push_back({ SCREEN_WIDTH / 2 / GRID_SIZE, SCREEN_HEIGHT / 2 / GRID_SIZE + i });
-    }
-
-    snake.direction = Direction::UP;
-    placeFood(snake);
-}
+void noteRenderEvent(const SDL_Event& event);
 
-bool handleInput(Snake& snake, bool& quit) {
+// Drains every pending event into inputQueue. Returns true if an arrow key
+// was pressed, even when the press itself was rejected.
+bool handleInput(const GameState& game, bool& quit) {
+    bool pressed = false;
 
     while (SDL_PollEvent(&e) != 0) {
+        noteRenderEvent(e);
         if (e.type == SDL_QUIT) {
             quit = true;
             return true;
         }
-        else if (e.type == SDL_KEYDOWN) {
+        else if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+            Direction direction;
             switch (e.key.keysym.sym) {
             case SDLK_UP:
-                if (snake.direction != Direction::DOWN) {
-                    snake.direction = Direction::UP;
-                }
-                return true;
+                direction = Direction::UP;
                 break;
             case SDLK_DOWN:
-                if (snake.direction != Direction::UP) {
-                    snake.direction = Direction::DOWN;
-                }
-                return true;
+                direction = Direction::DOWN;
                 break;
             case SDLK_LEFT:
-                if (snake.direction != Direction::RIGHT) {
-                    snake.direction = Direction::LEFT;
-                }
-                return true;
+                direction = Direction::LEFT;
                 break;
             case SDLK_RIGHT:
-                if (snake.direction != Direction::LEFT) {
-                    snake.direction = Direction::RIGHT;
-                }
-                return true;
+                direction = Direction::RIGHT;
                 break;
             default:
-                break;
+                continue;
             }
+            inputQueue.push(direction, game.direction, e.key.timestamp);
+            pressed = true;
         }
     }
-    return false;
+    return pressed;
 }
 
-int updateSnake(Snake& snake) {
-    Point newHead = snake.segments[0];
+// Applies the oldest queued press, if any, just before a tick.
+void applyQueuedInput(GameState& game) {
+    InputQueue::Entry entry;
+    if (!inputQueue.pop(entry)) return;
 
-    switch (snake.direction) {
-    case Direction::UP:
-        newHead.y -= 1;
-        break;
-    case Direction::DOWN:
-        newHead.y += 1;
-        break;
-    case Direction::LEFT:
-        newHead.x -= 1;
-        break;
-    case Direction::RIGHT:
-        newHead.x += 1;
-        break;
+    turn(game, entry.direction);
+    Uint32 latency = SDL_GetTicks() - (Uint32)entry.timestamp;
+    inputLatency.moves++;
+    inputLatency.totalMs += latency;
+    if (latency > inputLatency.maxMs) inputLatency.maxMs = latency;
+}
+
+// How the snake moved on the last tick, so frames drawn between ticks can
+// slide every segment from where it was towards where it is now.
+struct TickMotion {
+    bool moved = false; // false after a reset: draw segments where they are
+    bool grew = false;  // ate, so the tail stayed put
+    Point oldTail = { 0, 0 };
+};
+
+TickMotion lastMotion;
+
+// alpha is how far we are into the next tick, 0..1.
+void renderGame(const GameState& game, double alpha) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    int drawCalls = 0;
+
+    SDL_RenderClear(gRenderer);
+    if (batchedRendering) spriteBatch.begin(spriteAtlas);
+
+    auto draw = [&](Sprite sprite, double x, double y) {
+        if (batchedRendering) {
+            spriteBatch.add(spriteRects[sprite], (float)(x * GRID_SIZE), (float)(y * GRID_SIZE), (float)GRID_SIZE, (float)GRID_SIZE);
+        }
+        else {
+            SDL_Rect r = { (int)(x * GRID_SIZE + 0.5), (int)(y * GRID_SIZE + 0.5), GRID_SIZE, GRID_SIZE };
+            SDL_RenderCopy(gRenderer, spriteAtlas.texture(), &spriteRects[sprite], &r);
+            drawCalls++;
+        }
+    };
+
+    size_t count = game.segments.size();
+    for (size_t i = 0; i < count; i++) {
+        Point to = game.segments[i];
+        Point from = to;
+        if (lastMotion.moved) {
+            if (i + 1 < count) from = game.segments[i + 1];
+            else if (!lastMotion.grew) from = lastMotion.oldTail;
+        }
+        draw(i == 0 ? SPRITE_HEAD : SPRITE_BODY, from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha);
     }
 
-    // Crashing the wall
-    if (newHead.x < 0 || newHead.x >= SCREEN_WIDTH / GRID_SIZE || newHead.y < 0 || newHead.y >= SCREEN_HEIGHT / GRID_SIZE) {
-        initializeGame(snake);
-        return 1;
+    draw(SPRITE_FOOD, game.food.x, game.food.y);
+
+    if (batchedRendering) drawCalls = spriteBatch.flush(gRenderer);
+
+    frameStats.frames++;
+    frameStats.drawCalls += drawCalls;
+    frameStats.totalMs += (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    SDL_RenderPresent(gRenderer);
+}
+
+// Incremental rendering keeps the board in a target texture and each frame
+// only redraws the cells the ticks since the last frame touched: the old
+// tail, the old and new head and the new food. Anything that invalidates the
+// texture (a new game, a resize, lost render targets) forces a full redraw.
+bool incrementalRendering = false;
+SDL_Texture* boardTexture = NULL;
+bool boardNeedsFullRedraw = true;
+std::vector<Point> dirtyCells;
+
+struct IncrementalStats {
+    Uint64 frames = 0;
+    Uint64 cellsDrawn = 0;
+    Uint64 fullRedraws = 0;
+};
+
+IncrementalStats incrementalStats;
+
+// Records the cells one tick changed. Only renderGameIncremental() empties
+// the list, so nothing is recorded while drawing full frames.
+void markTickDirty(const GameState& game, const TickMotion& motion)
+{
+    if (!incrementalRendering) return;
+    if (!motion.moved) {
+        boardNeedsFullRedraw = true;
+        return;
     }
+    dirtyCells.push_back(game.segments[0]);
+    if (game.segments.size() > 1) dirtyCells.push_back(game.segments[1]);
+    if (motion.grew) dirtyCells.push_back(game.food);
+    else dirtyCells.push_back(motion.oldTail);
+}
 
-    // Eating food or keep moving
-    if (newHead.x == food.x && newHead.y == food.y) { // eating
-        snake.segments.insert(snake.segments.begin(), newHead);
-        placeFood(snake);
-        return 2;
+// Window and renderer events that throw away what the board texture shows.
+void noteRenderEvent(const SDL_Event& event)
+{
+    if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET ||
+        (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+        boardNeedsFullRedraw = true;
     }
-    else {
-        snake.segments.pop_back(); // or not
-        snake.segments.insert(snake.segments.begin(), newHead);
+}
+
+// Draws whatever is on the cell now, over the background colour.
+void drawCell(const GameState& game, Point p)
+{
+    SDL_Rect r = { p.x * GRID_SIZE, p.y * GRID_SIZE, GRID_SIZE, GRID_SIZE };
+    SDL_RenderFillRect(gRenderer, &r);
+    if (p == game.segments.front()) spriteBatch.add(spriteRects[SPRITE_HEAD], (float)r.x, (float)r.y, (float)r.w, (float)r.h);
+    else if (game.occupied.test(p)) spriteBatch.add(spriteRects[SPRITE_BODY], (float)r.x, (float)r.y, (float)r.w, (float)r.h);
+    else if (p == game.food) spriteBatch.add(spriteRects[SPRITE_FOOD], (float)r.x, (float)r.y, (float)r.w, (float)r.h);
+}
+
+void renderGameIncremental(const GameState& game)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    if (boardTexture == NULL) {
+        boardTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+            game.config.width * GRID_SIZE, game.config.height * GRID_SIZE);
+        boardNeedsFullRedraw = true;
     }
 
-    // If snake crashing on it self
-    for (size_t i = 1; i < snake.segments.size(); i++) {
-        if (newHead.x == snake.segments[i].x && newHead.y == snake.segments[i].y) {
-            initializeGame(snake);
-            return 3;
-        }
+    SDL_SetRenderTarget(gRenderer, boardTexture);
+    spriteBatch.begin(spriteAtlas);
+    if (boardNeedsFullRedraw) {
+        SDL_RenderClear(gRenderer);
+        for (const auto& segment : game.segments) drawCell(game, segment);
+        drawCell(game, game.food);
+        incrementalStats.fullRedraws++;
+    }
+    else {
+        for (Point cell : dirtyCells) drawCell(game, cell);
     }
+    incrementalStats.cellsDrawn += spriteBatch.sprites();
+    int drawCalls = spriteBatch.flush(gRenderer);
+    dirtyCells.clear();
+    boardNeedsFullRedraw = false;
 
-    return 0; // nothing to be concern
+    SDL_SetRenderTarget(gRenderer, NULL);
+    SDL_RenderClear(gRenderer);
+    SDL_RenderCopy(gRenderer, boardTexture, NULL, NULL);
+
+    incrementalStats.frames++;
+    frameStats.frames++;
+    frameStats.drawCalls += drawCalls + 1;
+    frameStats.totalMs += (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    SDL_RenderPresent(gRenderer);
 }
 
-void renderGame(Snake& snake) {
-    SDL_RenderClear(gRenderer);
+void playResultSound(int result)
+{
+    switch (result)
+    {
+    case STEP_CRASH_WALL:
+        soundEffects.play(SFX_CRASH_WALL);
+        break;
+    case STEP_EAT:
+    case STEP_BOARD_FULL:
+        soundEffects.play(SFX_BITE);
+        break;
+    case STEP_CRASH_SELF:
+        soundEffects.play(SFX_CRASH_SELF);
+        break;
+    default:
+        break;
+    }
+}
 
-    for (size_t i = 0; i < snake.segments.size(); ++i) {
-        SDL_Rect r = { snake.segments[i].x * GRID_SIZE, snake.segments[i].y * GRID_SIZE, GRID_SIZE, GRID_SIZE };
-        if (i == 0) {
-            SDL_RenderCopy(gRenderer, snake.headTexture, NULL, &r);
-        }
-        else {
-            SDL_RenderCopy(gRenderer, snake.bodyTexture, NULL, &r);
-        }
+// Whole file contents, or "" if it can't be read.
+std::string readFile(const std::string& path)
+{
+    std::string contents;
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "rb");
+    if (file == NULL) return contents;
+    Sint64 size = SDL_RWsize(file);
+    if (size > 0) {
+        contents.resize((size_t)size);
+        if (SDL_RWread(file, &contents[0], contents.size(), 1) != 1) contents.clear();
     }
+    SDL_RWclose(file);
+    return contents;
+}
 
-    SDL_Rect rFood = { food.x * GRID_SIZE, food.y * GRID_SIZE, GRID_SIZE, GRID_SIZE };
-    SDL_RenderCopy(gRenderer, foodTexture, NULL, &rFood);
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    SDL_RWops* file = SDL_RWFromFile(path.c_str(), "wb");
+    if (file == NULL) return false;
+    bool ok = data.empty() || SDL_RWwrite(file, data.data(), data.size(), 1) == 1;
+    return SDL_RWclose(file) == 0 && ok;
+}
 
-    SDL_RenderPresent(gRenderer);
+// Queues a file from the pack if it has one by that name, else from disk.
+int addAsset(AssetLoader& loader, const AssetPack& pack, AssetKind kind, const std::string& name)
+{
+    long entry = pack.find(name);
+    if (entry < 0) return loader.add(kind, name);
+    return loader.add(kind, name, pack.data(entry), pack.size(entry));
 }
 
 bool setUpThing()
@@ -211,102 +315,432 @@ bool setUpThing()
         std::cout << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         return 0;
     }
-    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (gRenderer == NULL) {
         std::cout << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         return 0;
     }
 
-    // CREATE TEXTURE
-    snakeHeadTexture = loadTexture("img\\snake_head.png", gRenderer);
-    snakeBodyTexture = loadTexture("img\\snake_body.png", gRenderer);
-    foodTexture = loadTexture("img\\apple.png", gRenderer);
-    if (snakeHeadTexture == NULL || snakeBodyTexture == NULL || foodTexture == NULL) {
-        std::cout << "Failed to load textures." << std::endl;
-        return 1;
+    // LOADING ASSETS
+    // Images and sounds decode on worker threads. Meanwhile this thread opens
+    // the audio device (the buffer probe takes a while), and the atlas is
+    // uploaded as soon as the last image is in, while sounds may still be
+    // decoding.
+    // With an asset pack next to the game, everything is read from its single
+    // mapping; otherwise from the loose files in img/ and sfx/.
+    IMG_Init(IMG_INIT_PNG);
+    AssetPack pack;
+    if (pack.open(ASSET_PACK)) std::cout << "Reading assets from " << ASSET_PACK << std::endl;
+    std::vector<std::string> spriteFiles;
+    if (pack.isOpen()) {
+        for (size_t i = 0; i < pack.count(); i++) {
+            std::string_view name = pack.name(i);
+            if (name.size() > 8 && name.substr(0, 4) == "img/" && name.substr(name.size() - 4) == ".png") {
+                spriteFiles.push_back(std::string(name));
+            }
+        }
+    }
+    else {
+        spriteFiles = listSpriteFiles("img");
+    }
+
+    // The sprite files are only hashed at first: if the atlas cache was built
+    // from the same files, it is uploaded as-is and no image is decoded.
+    std::vector<std::string> names;
+    std::vector<std::string> looseSprites(spriteFiles.size());
+    std::vector<std::string_view> spriteData;
+    for (size_t i = 0; i < spriteFiles.size(); i++) {
+        long entry = pack.find(spriteFiles[i]);
+        if (entry >= 0) {
+            spriteData.push_back(std::string_view((const char*)pack.data(entry), pack.size(entry)));
+        }
+        else {
+            looseSprites[i] = readFile(spriteFiles[i]);
+            spriteData.push_back(looseSprites[i]);
+        }
+        names.push_back(spriteName(spriteFiles[i]));
+    }
+    Uint64 spriteKey = spriteSourceHash(names, spriteData);
+    names.clear();
+
+    Uint64 cacheStart = SDL_GetPerformanceCounter();
+    bool atlasOk = spriteAtlas.loadCache(gRenderer, ATLAS_CACHE, spriteKey);
+    if (atlasOk) {
+        std::cout << "Uploaded sprite atlas from " << ATLAS_CACHE << " in "
+            << (SDL_GetPerformanceCounter() - cacheStart) * 1000.0 / SDL_GetPerformanceFrequency() << " ms" << std::endl;
+    }
+
+    AssetLoader loader(std::max(2, SDL_GetCPUCount()));
+    if (!atlasOk) {
+        for (size_t i = 0; i < spriteFiles.size(); i++) {
+            loader.add(ASSET_IMAGE, spriteFiles[i], spriteData[i].data(), spriteData[i].size());
+        }
+    }
+
+    const char* const soundFiles[SFX_COUNT] = { "sfx/bite.mp3", "sfx/crashWall.mp3", "sfx/uwu.mp3" };
+    int soundIds[SFX_COUNT];
+    bool audioOpen = openAudio(audioSettings);
+    if (!audioOpen) {
+        std::cout << "Failed to open audio: " << Mix_GetError() << std::endl;
+    }
+    else {
+        std::cout << "Audio: " << audioSettings.frequency << " Hz, " << audioSettings.channels << " channels, "
+            << audioSettings.bufferSamples << " sample buffer ("
+            << 1000.0 * audioSettings.bufferSamples / audioSettings.frequency << " ms)" << std::endl;
+        Mix_Init(MIX_INIT_MP3);
+        for (int i = 0; i < SFX_COUNT; i++) soundIds[i] = addAsset(loader, pack, ASSET_SOUND, soundFiles[i]);
+    }
+
+    std::vector<SDL_Surface*> images;
+    size_t imagesLeft = atlasOk ? 0 : spriteFiles.size();
+    for (int id = loader.next(); id != -1; id = loader.next()) {
+        Asset& asset = loader.asset(id);
+        if (asset.error.empty()) {
+            std::cout << "Decoded " << asset.path << " in " << asset.decodeMs << " ms" << std::endl;
+        }
+        else {
+            std::cout << "Failed to load " << asset.path << ": " << asset.error << std::endl;
+        }
+        if (asset.kind != ASSET_IMAGE) continue;
+
+        if (asset.image != NULL) {
+            names.push_back(spriteName(asset.path));
+            images.push_back(asset.image);
+        }
+        if (--imagesLeft == 0) {
+            Uint64 uploadStart = SDL_GetPerformanceCounter();
+            atlasOk = !images.empty() && spriteAtlas.build(gRenderer, names, images, ATLAS_CACHE, spriteKey);
+            for (SDL_Surface* image : images) SDL_FreeSurface(image);
+            std::cout << "Uploaded sprite atlas in "
+                << (SDL_GetPerformanceCounter() - uploadStart) * 1000.0 / SDL_GetPerformanceFrequency() << " ms" << std::endl;
+        }
     }
 
-    // LOADING SOUND EFFECTS
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-    bite = Mix_LoadMUS("sfx\\bite.mp3");
-    crashWall = Mix_LoadMUS("sfx\\crashWall.mp3");
-    crashSelf = Mix_LoadMUS("sfx\\uwu.mp3");
+    if (audioOpen) {
+        Mix_Chunk* chunks[SFX_COUNT];
+        for (int i = 0; i < SFX_COUNT; i++) chunks[i] = loader.asset(soundIds[i]).sound;
+        soundEffects.attach(chunks, audioSettings);
+    }
 
+    if (!atlasOk) {
+        std::cout << "Failed to load textures." << std::endl;
+        return 0;
+    }
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        const SDL_Rect* rect = spriteAtlas.find(spriteNames[i]);
+        if (rect == NULL) {
+            std::cout << "Missing sprite img/" << spriteNames[i] << ".png" << std::endl;
+            return 0;
+        }
+        spriteRects[i] = *rect;
+    }
 
     return 1;
 }
 
 void DELETE()
 {
-    Mix_FreeMusic(bite);
-    Mix_FreeMusic(crashWall);
-    Mix_FreeMusic(crashSelf);
+    if (boardTexture != NULL) SDL_DestroyTexture(boardTexture);
+    spriteBatch.destroy();
+    spriteAtlas.destroy();
+    soundEffects.free();
+    Mix_CloseAudio();
     SDL_DestroyRenderer(gRenderer);
     SDL_DestroyWindow(gWindow);
     gRenderer = NULL;
     gWindow = NULL;
 }
 
+// Command line: --seed N replays the exact same food placement,
+// --tick-rate HZ sets how many simulation ticks run per second,
+// --legacy-render draws sprites one SDL_RenderCopy at a time (for comparison),
+// --composite-batch blends the batch on the CPU into one draw on SDL older
+// than 2.0.18 (off by default there until it measures faster),
+// --incremental-render redraws only changed cells (no in-between frames),
+// --audio-rate HZ, --audio-channels N and --audio-buffer SAMPLES set up the
+// mixer (buffer 0, the default, probes for the smallest stable size),
+// --record FILE saves the session as a replay on exit,
+// --replay FILE plays one back instead of reading the keyboard,
+// --broadcast FILE saves the spectator stream of the session on exit,
+// --spectate FILE shows one, drawn from the stream alone.
+struct Options {
+    uint64_t seed = 0;
+    bool hasSeed = false;
+    double tickRate = 1000.0 / timeDelay;
+    bool legacyRender = false;
+    bool compositeBatch = false;
+    bool incrementalRender = false;
+    AudioSettings audio;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    const char* broadcastPath = NULL;
+    const char* spectatePath = NULL;
+};
+
+Options parseOptions(int argc, char* args[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(args[++i], NULL, 10);
+            options.hasSeed = true;
+        }
+        else if (strcmp(args[i], "--tick-rate") == 0 && i + 1 < argc) {
+            double rate = atof(args[++i]);
+            if (rate > 0) options.tickRate = rate;
+        }
+        else if (strcmp(args[i], "--legacy-render") == 0) {
+            options.legacyRender = true;
+        }
+        else if (strcmp(args[i], "--composite-batch") == 0) {
+            options.compositeBatch = true;
+        }
+        else if (strcmp(args[i], "--incremental-render") == 0) {
+            options.incrementalRender = true;
+        }
+        else if (strcmp(args[i], "--audio-rate") == 0 && i + 1 < argc) {
+            int rate = atoi(args[++i]);
+            if (rate > 0) options.audio.frequency = rate;
+        }
+        else if (strcmp(args[i], "--audio-channels") == 0 && i + 1 < argc) {
+            int channels = atoi(args[++i]);
+            if (channels > 0) options.audio.channels = channels;
+        }
+        else if (strcmp(args[i], "--audio-buffer") == 0 && i + 1 < argc) {
+            int samples = atoi(args[++i]);
+            if (samples >= 0) options.audio.bufferSamples = samples;
+        }
+        else if (strcmp(args[i], "--record") == 0 && i + 1 < argc) {
+            options.recordPath = args[++i];
+        }
+        else if (strcmp(args[i], "--replay") == 0 && i + 1 < argc) {
+            options.replayPath = args[++i];
+        }
+        else if (strcmp(args[i], "--broadcast") == 0 && i + 1 < argc) {
+            options.broadcastPath = args[++i];
+        }
+        else if (strcmp(args[i], "--spectate") == 0 && i + 1 < argc) {
+            options.spectatePath = args[++i];
+        }
+    }
+    return options;
+}
+
 int main(int argc, char* args[]) {
     
+    Options options = parseOptions(argc, args);
+    audioSettings = options.audio;
+
+    Uint64 startupStart = SDL_GetPerformanceCounter();
     if (!setUpThing()) return 0; 
+    std::cout << "Startup took " << (SDL_GetPerformanceCounter() - startupStart) * 1000.0 / SDL_GetPerformanceFrequency()
+        << " ms" << std::endl;
+    if (options.legacyRender) batchedRendering = false;
+    spriteBatch.setCompositing(options.compositeBatch);
+    if (options.incrementalRender) {
+        incrementalRendering = SDL_RenderTargetSupported(gRenderer) == SDL_TRUE;
+        if (!incrementalRendering) std::cout << "Render targets not supported, drawing full frames." << std::endl;
+    }
 
-    Snake snake;
+    GameState game;
     bool quit = false;
     bool newgame = true;
+    bool gameOver = false;
+
+    GameConfig config;
+    config.width = SCREEN_WIDTH / GRID_SIZE;
+    config.height = SCREEN_HEIGHT / GRID_SIZE;
+    config.initialLength = INITIAL_SNAKE_LENGTH;
+    uint64_t seed = options.hasSeed ? options.seed : (uint64_t)SDL_GetPerformanceCounter();
+
+    // A replay brings its own board and seed, and needs no key to start.
+    std::string replayData;
+    ReplayReader replay;
+    bool replaying = false;
+    if (options.replayPath != NULL) {
+        replayData = readFile(options.replayPath);
+        replaying = replay.open((const uint8_t*)replayData.data(), replayData.size());
+        if (!replaying) {
+            std::cout << "Cannot read replay " << options.replayPath << std::endl;
+        }
+        else {
+            config = replay.config();
+            seed = replay.seed();
+            newgame = false;
+        }
+    }
+    // A spectator only decodes frames; the local game is never stepped.
+    std::string spectateData;
+    size_t spectateOffset = 0;
+    SpectatorDecoder spectator;
+    bool spectating = false;
+    if (options.spectatePath != NULL) {
+        spectateData = readFile(options.spectatePath);
+        spectateOffset = spectator.decode((const uint8_t*)spectateData.data(), spectateData.size());
+        spectating = spectateOffset > 0;
+        if (!spectating) std::cout << "Cannot read spectator stream " << options.spectatePath << std::endl;
+        else newgame = false;
+    }
+    std::cout << "Seed: " << seed << std::endl;
+    newGame(game, config, seed);
+    const GameState& shown = spectating ? spectator.state() : game;
+
+    SpectatorEncoder broadcaster;
+    std::vector<uint8_t> broadcastData;
+    if (options.broadcastPath != NULL) broadcaster.encode(game, broadcastData);
 
-    initializeGame(snake);
+    ReplayRecorder recorder;
+    if (options.recordPath != NULL) recorder.start(config, seed);
     SDL_SetRenderDrawColor(gRenderer, 100, 200, 255, 255);
+
+    SDL_RendererInfo rendererInfo;
+    SDL_GetRendererInfo(gRenderer, &rendererInfo);
+    bool vsync = (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+
+    // Fixed timestep: the simulation advances in whole ticks of tickSeconds
+    // taken out of an accumulator of real time, and every frame in between
+    // is drawn with the snake part of the way to its next position.
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const double tickSeconds = 1.0 / options.tickRate;
+    double accumulator = 0;
+    Uint64 previous = SDL_GetPerformanceCounter();
+    Uint64 gameOverUntil = 0;
+
     while (!quit) {
-        renderGame(snake);
-        SDL_Delay(timeDelay);
-        while (newgame)
-        {
-            SDL_Delay(timeDelay);
-            if (handleInput(snake, quit)) newgame = false;
-        }
-
-        handleInput(snake, quit);
-        //int n = ;
-        switch (updateSnake(snake))
-        {
-        case 1: // crash wall
-            Mix_PlayMusic(crashWall, 0);
-            newgame = true;
-            for (int i = 0; i < 10; i++)
-            {
-                SDL_Delay(200);
-                if (SDL_PollEvent(&e) != 0 && e.type == SDL_QUIT) {
-                    quit = true;
-                    newgame = false;
-                    break;
-                }
+        Uint64 now = SDL_GetPerformanceCounter();
+        double frameSeconds = (double)(now - previous) / frequency;
+        previous = now;
+        if (frameSeconds > 0.25) frameSeconds = 0.25; // after a stall, don't fast-forward
+
+        if (gameOver) {
+            while (SDL_PollEvent(&e) != 0) {
+                if (e.type == SDL_QUIT) quit = true;
+                noteRenderEvent(e);
+            }
+            if (now >= gameOverUntil) {
+                gameOver = false;
+                newgame = !replaying; // a replay carries on by itself
+            }
+        }
+        else if (newgame) {
+            if (handleInput(game, quit)) {
+                newgame = false;
+                accumulator = 0;
             }
-            break;
-        case 2: // eat food
-            Mix_PlayMusic(bite, 0);
-            break;
-        case 3: // crash itself
-            Mix_PlayMusic(crashSelf, 0);
-            newgame = true;
-            for (int i = 0; i < 10; i++)
-            {
-                SDL_Delay(200);
-                if (SDL_PollEvent(&e) != 0 && e.type == SDL_QUIT) {
-                    quit = true;
-                    newgame = false;
+        }
+        else {
+            handleInput(game, quit);
+            accumulator += frameSeconds;
+            while (accumulator >= tickSeconds) {
+                accumulator -= tickSeconds;
+
+                if (spectating) {
+                    size_t used = spectator.decode((const uint8_t*)spectateData.data() + spectateOffset,
+                        spectateData.size() - spectateOffset);
+                    if (used == 0) {
+                        quit = true;
+                        break;
+                    }
+                    spectateOffset += used;
+                    lastMotion.moved = spectator.snakeMoved();
+                    lastMotion.grew = spectator.grew();
+                    lastMotion.oldTail = spectator.oldTail();
+                    markTickDirty(shown, lastMotion);
+                    continue;
+                }
+
+                Direction heading = game.direction;
+                if (replaying) {
+                    bool turns;
+                    Direction direction;
+                    if (!replay.next(turns, direction)) {
+                        quit = true;
+                        break;
+                    }
+                    if (turns) turn(game, direction);
+                }
+                else {
+                    applyQueuedInput(game);
+                }
+                if (options.recordPath != NULL) recorder.tick(heading, game.direction);
+
+                TickMotion motion;
+                motion.oldTail = game.segments.back();
+                int result = updateSnake(game);
+                motion.moved = !isGameOver(result);
+                motion.grew = result == STEP_EAT;
+                lastMotion = motion;
+                markTickDirty(game, motion);
+
+                playResultSound(result);
+                if (isGameOver(result)) initializeGame(game);
+                if (options.broadcastPath != NULL) broadcaster.encode(game, broadcastData);
+                if (isGameOver(result)) {
+                    inputQueue.clear();
+                    gameOver = true;
+                    gameOverUntil = now + frequency * GAME_OVER_PAUSE_MS / 1000;
+                    accumulator = 0;
                     break;
                 }
             }
-            break;
-        default:
-            break;
         }
+
+        double alpha = newgame || gameOver ? 1.0 : accumulator / tickSeconds;
+        if (incrementalRendering) renderGameIncremental(shown);
+        else renderGame(shown, alpha);
+        if (!vsync) SDL_Delay(1);
+    }
+
+    if (options.recordPath != NULL) {
+        recorder.finish();
+        if (recorder.save(options.recordPath)) {
+            std::cout << "Recorded " << recorder.ticks() << " ticks in " << recorder.bytes().size()
+                << " bytes to " << options.recordPath << std::endl;
+        }
+        else {
+            std::cout << "Failed to save replay " << options.recordPath << std::endl;
+        }
+    }
+    if (options.broadcastPath != NULL) {
+        const SpectatorStats& stats = broadcaster.stats();
+        if (writeFile(options.broadcastPath, broadcastData)) {
+            std::cout << "Broadcast " << stats.frames << " frames in " << stats.bytes << " bytes to " << options.broadcastPath
+                << " (" << stats.keyframes << " keyframes, " << stats.keyframeBytes << " bytes), avg "
+                << (stats.frames > 0 ? (double)stats.bytes / stats.frames : 0) << " bytes/tick, "
+                << (stats.frames > 0 ? (double)stats.bytes / stats.frames * 8 * options.tickRate : 0)
+                << " bit/s per spectator" << std::endl;
+        }
+        else {
+            std::cout << "Failed to save spectator stream " << options.broadcastPath << std::endl;
+        }
+    }
+    if (incrementalStats.frames > 0) {
+        std::cout << "Incremental render: avg " << (double)incrementalStats.cellsDrawn / incrementalStats.frames
+            << " cells/frame, " << incrementalStats.fullRedraws << " full redraws over "
+            << incrementalStats.frames << " frames" << std::endl;
+    }
+    if (frameStats.frames > 0) {
+        std::cout << (incrementalRendering ? "Incremental" : !batchedRendering ? "Legacy" :
+            spriteBatch.compositing() ? "Composited batch" : "Batched") << " render: avg "
+            << frameStats.totalMs / frameStats.frames << " ms/frame, "
+            << (double)frameStats.drawCalls / frameStats.frames << " draw calls/frame over "
+            << frameStats.frames << " frames" << std::endl;
+    }
+    SoundEffects::LatencyStats sfxLatency = soundEffects.latency();
+    if (sfxLatency.plays > 0) {
+        std::cout << "Sound play latency (play to first mix): avg " << sfxLatency.averageMs
+            << " ms, max " << sfxLatency.maxMs << " ms over " << sfxLatency.plays << " plays" << std::endl;
+        std::cout << "Sound event-to-output latency: avg " << sfxLatency.averageMs + sfxLatency.bufferMs
+            << " ms (" << sfxLatency.bufferMs << " ms device buffer), "
+            << sfxLatency.underruns << " underruns" << std::endl;
+    }
+    if (inputLatency.moves > 0) {
+        std::cout << "Input-to-move latency: avg " << (double)inputLatency.totalMs / inputLatency.moves
+            << " ms, max " << inputLatency.maxMs << " ms over " << inputLatency.moves << " turns" << std::endl;
     }
 
-    
     DELETE();
     SDL_Quit();
 
     return 0;
-}
\ No newline at end of file
+}
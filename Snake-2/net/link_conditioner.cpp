@@ -0,0 +1,36 @@
+#include "link_conditioner.h"
+
+LinkConditioner::LinkConditioner(UdpSocket& socket, const LinkConditions& conditions, uint64_t seed)
+    : socket(socket), conditions(conditions), rng(seed) {}
+
+void LinkConditioner::send(const NetAddress& to, const void* data, size_t size, uint64_t nowMs) {
+    // 53 random bits give a uniform double in [0, 1).
+    double roll = (double)(rng.next() >> 11) / (double)(1ull << 53);
+    if (roll < conditions.loss) {
+        droppedCount++;
+        return;
+    }
+
+    int64_t delay = conditions.latencyMs;
+    if (conditions.jitterMs > 0) delay += (int64_t)rng.below(2 * conditions.jitterMs + 1) - conditions.jitterMs;
+    if (delay < 0) delay = 0;
+
+    const uint8_t* bytes = (const uint8_t*)data;
+    queue.push_back({ nowMs + (uint64_t)delay, to, std::vector<uint8_t>(bytes, bytes + size) });
+    flush(nowMs);
+}
+
+void LinkConditioner::flush(uint64_t nowMs) {
+    size_t kept = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].dueMs <= nowMs) {
+            socket.sendTo(queue[i].to, queue[i].data.data(), queue[i].data.size());
+            sentCount++;
+        }
+        else {
+            if (kept != i) queue[kept] = std::move(queue[i]);
+            kept++;
+        }
+    }
+    queue.resize(kept);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../core/rng.h"
+#include "udp_socket.h"
+
+// Bad network conditions applied to outgoing datagrams, for trying netcode
+// on localhost: every datagram is held back by latency +/- jitter
+// (uniform), which also reorders them, or dropped outright with
+// probability `loss`.
+struct LinkConditions {
+    int latencyMs = 0;
+    int jitterMs = 0;
+    double loss = 0; // 0..1
+};
+
+class LinkConditioner {
+public:
+    LinkConditioner(UdpSocket& socket, const LinkConditions& conditions, uint64_t seed);
+
+    // Queues the datagram for later, or drops it.
+    void send(const NetAddress& to, const void* data, size_t size, uint64_t nowMs);
+
+    // Sends every queued datagram whose time has come.
+    void flush(uint64_t nowMs);
+
+    uint64_t sent() const { return sentCount; }
+    uint64_t dropped() const { return droppedCount; }
+
+private:
+    struct Pending {
+        uint64_t dueMs;
+        NetAddress to;
+        std::vector<uint8_t> data;
+    };
+
+    UdpSocket& socket;
+    LinkConditions conditions;
+    Rng rng;
+    std::vector<Pending> queue;
+    uint64_t sentCount = 0;
+    uint64_t droppedCount = 0;
+};
@@ -0,0 +1,161 @@
+#include "rollback_session.h"
+
+// Packet: 'R', sender's player number, then little-endian uint32 ack (all
+// of the receiver's inputs below this frame have arrived), uint32 first
+// frame, uint8 count, and count input bytes from the first frame on.
+static const uint8_t PACKET_MAGIC = 'R';
+static const size_t PACKET_HEADER = 11;
+static const int MAX_INPUTS_PER_PACKET = RollbackSession::MAX_PACKET - (int)PACKET_HEADER;
+
+static void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static ArenaConfig twoSnakes(ArenaConfig config) {
+    config.snakes = 2;
+    return config;
+}
+
+RollbackSession::RollbackSession(int localPlayer, const ArenaConfig& config, uint64_t seed, int inputDelay, int maxRollback)
+    : local(localPlayer), remote(1 - localPlayer), inputDelay(inputDelay), maxRollback(maxRollback),
+      arena(twoSnakes(config), seed), history(maxRollback + 2, arena) {
+    for (int i = 0; i < INPUT_WINDOW; i++) {
+        localInputs[i] = INPUT_KEEP;
+        remoteInputs[i] = INPUT_KEEP;
+        remoteFrames[i] = 0;
+        guesses[i] = INPUT_KEEP;
+    }
+    // Nobody can have input for the first inputDelay frames: they go
+    // straight on, on both peers, without waiting for anything.
+    for (int f = 0; f < inputDelay; f++) remoteFrames[f % INPUT_WINDOW] = f + 1;
+    remoteReceived = inputDelay;
+    peerAcked = inputDelay;
+}
+
+void RollbackSession::simulate(uint64_t frame) {
+    history[frame % history.size()] = arena; // same sizes every time, so no allocation
+    guesses[frame % INPUT_WINDOW] = remoteInput(frame);
+    uint8_t inputs[2] = { localInputs[frame % INPUT_WINDOW], guesses[frame % INPUT_WINDOW] };
+    uint8_t actions[2];
+    actions[local] = inputs[0] < INPUT_KEEP ? inputs[0] : (uint8_t)arena.direction(local);
+    actions[remote] = inputs[1] < INPUT_KEEP ? inputs[1] : (uint8_t)arena.direction(remote);
+    arena.step(actions);
+}
+
+uint8_t RollbackSession::remoteInput(uint64_t frame) const {
+    int slot = (int)(frame % INPUT_WINDOW);
+    return remoteFrames[slot] == frame + 1 ? remoteInputs[slot] : INPUT_KEEP;
+}
+
+void RollbackSession::resolve() {
+    if (lostSync || rollbackFrom >= currentFrame) return;
+
+    uint64_t depth = currentFrame - rollbackFrom;
+    if (depth > history.size()) {
+        sessionStats.desyncs++;
+        lostSync = true;
+        rollbackFrom = UINT64_MAX;
+        return;
+    }
+
+    bool wasAlive = arena.alive(local);
+    Point head = arena.head(local);
+    int length = arena.length(local);
+    arena = history[rollbackFrom % history.size()];
+    for (uint64_t f = rollbackFrom; f < currentFrame; f++) simulate(f);
+    if (arena.alive(local) != wasAlive || arena.head(local) != head || arena.length(local) != length) {
+        sessionStats.localChanges++;
+    }
+
+    sessionStats.rollbacks++;
+    sessionStats.resimulatedFrames += depth;
+    if (depth > sessionStats.maxRollbackFrames) sessionStats.maxRollbackFrames = depth;
+    rollbackFrom = UINT64_MAX;
+}
+
+bool RollbackSession::advance(uint8_t input) {
+    resolve();
+    if (lostSync) return false;
+
+    // Past this the boards needed to correct a guess would be gone, or our
+    // unacknowledged inputs would no longer fit the window.
+    if (currentFrame >= remoteReceived + maxRollback ||
+        currentFrame + inputDelay - peerAcked >= (uint64_t)MAX_INPUTS_PER_PACKET) {
+        sessionStats.stalls++;
+        return false;
+    }
+
+    localInputs[(currentFrame + inputDelay) % INPUT_WINDOW] = input;
+    simulate(currentFrame);
+
+    currentFrame++;
+    sessionStats.frames++;
+    return true;
+}
+
+size_t RollbackSession::writePacket(uint8_t* buffer) const {
+    uint64_t scheduled = currentFrame + inputDelay; // local inputs exist below this
+    uint64_t count = scheduled - peerAcked;
+    if (count > (uint64_t)MAX_INPUTS_PER_PACKET) count = MAX_INPUTS_PER_PACKET;
+
+    buffer[0] = PACKET_MAGIC;
+    buffer[1] = (uint8_t)local;
+    putU32(buffer + 2, (uint32_t)remoteReceived);
+    putU32(buffer + 6, (uint32_t)peerAcked);
+    buffer[10] = (uint8_t)count;
+    for (uint64_t i = 0; i < count; i++) buffer[PACKET_HEADER + i] = localInputs[(peerAcked + i) % INPUT_WINDOW];
+    return PACKET_HEADER + (size_t)count;
+}
+
+void RollbackSession::readPacket(const uint8_t* data, size_t size) {
+    if (size < PACKET_HEADER || data[0] != PACKET_MAGIC || data[1] != remote) return;
+    uint64_t ack = getU32(data + 2);
+    uint64_t first = getU32(data + 6);
+    size_t count = data[10];
+    if (size < PACKET_HEADER + count) return;
+    sessionStats.packetsRead++;
+
+    if (ack > peerAcked && ack <= currentFrame + inputDelay) peerAcked = ack;
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t f = first + i;
+        uint8_t input = data[PACKET_HEADER + i];
+        if (f < remoteReceived || f >= remoteReceived + INPUT_WINDOW || input > INPUT_KEEP) continue;
+
+        int slot = (int)(f % INPUT_WINDOW);
+        if (remoteFrames[slot] == f + 1) continue;
+        remoteInputs[slot] = input;
+        remoteFrames[slot] = f + 1;
+        if (f < currentFrame && guesses[slot] != input) {
+            sessionStats.mispredictions++;
+            if (f < rollbackFrom) rollbackFrom = f;
+        }
+    }
+    while (remoteFrames[remoteReceived % INPUT_WINDOW] == remoteReceived + 1) remoteReceived++;
+}
+
+uint64_t RollbackSession::checksum() const {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+    const ArenaConfig& config = arena.config();
+    mix(arena.stats().ticks);
+    for (int snake = 0; snake < arena.size(); snake++) {
+        mix(arena.alive(snake));
+        if (!arena.alive(snake)) continue;
+        mix((uint64_t)arena.direction(snake));
+        for (int i = 0; i < arena.length(snake); i++) {
+            Point p = arena.segment(snake, i);
+            mix((uint64_t)p.x << 32 | (uint32_t)p.y);
+        }
+    }
+    for (int y = 0; y < config.height; y++) {
+        for (int x = 0; x < config.width; x++) {
+            if (arena.hasFood({ x, y })) mix((uint64_t)x << 32 | (uint32_t)y);
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../core/arena.h"
+
+// One byte per player per frame: 0-3 turns to that Direction, INPUT_KEEP
+// carries on straight.
+const uint8_t INPUT_KEEP = 4;
+
+struct RollbackStats {
+    uint64_t frames = 0;            // frames advanced
+    uint64_t stalls = 0;            // advance() calls refused: remote too far behind
+    uint64_t mispredictions = 0;    // remote inputs that differed from the guess
+    uint64_t rollbacks = 0;         // times earlier frames had to be re-simulated
+    uint64_t resimulatedFrames = 0;
+    uint64_t maxRollbackFrames = 0; // deepest single rollback
+    uint64_t desyncs = 0;           // corrections older than the oldest kept board
+    uint64_t localChanges = 0;      // rollbacks that also changed the local snake
+    uint64_t packetsRead = 0;
+};
+
+// Two-player session with GGPO-style rollback. Both snakes live on one
+// shared Arena board, stepped with both players' inputs each frame, so they
+// can block each other, collide head-on and race for the same food. A late
+// remote input can therefore change what happened to the local snake as
+// well, and a correction re-simulates the whole board.
+//
+// Local input is scheduled inputDelay frames ahead, which hides that much
+// latency outright. Past that, a frame whose remote input has not arrived
+// is simulated with a guess ("keep going": turns are rare), and when the
+// real input turns out different the board is restored from the copy kept
+// before that frame and re-simulated. If the remote player falls more than
+// maxRollback frames behind, advance() stalls instead of guessing further.
+// Should a correction ever reach past the oldest copy anyway, the board can
+// no longer be trusted: the session marks itself desynced and stops
+// advancing, and the caller has to resync or drop the peer.
+//
+// The session never touches a socket: writePacket() and readPacket() give
+// and take datagrams, so it runs the same over UDP or in memory. Packets
+// carry every local input the peer has not acknowledged yet, so a lost
+// packet is covered by the next one.
+class RollbackSession {
+public:
+    static const int INPUT_WINDOW = 128; // frames of input kept, must exceed maxRollback + inputDelay
+    static const int MAX_PACKET = 96;
+
+    // config.snakes is set to 2; player p steers snake p.
+    RollbackSession(int localPlayer, const ArenaConfig& config, uint64_t seed, int inputDelay, int maxRollback);
+
+    // Advances one frame, scheduling `input` for frame() + inputDelay.
+    // Returns false without using the input when stalled or desynced.
+    bool advance(uint8_t input);
+
+    // Re-simulates now if a packet showed an earlier guess was wrong;
+    // advance() does this anyway. For settling once input has stopped.
+    void resolve();
+
+    // Fills buffer (at least MAX_PACKET bytes) and returns the packet size.
+    size_t writePacket(uint8_t* buffer) const;
+    // Ignores malformed packets and ones not from the remote player.
+    void readPacket(const uint8_t* data, size_t size);
+
+    uint64_t frame() const { return currentFrame; }
+    // Frames for which both players' inputs are known.
+    uint64_t confirmedFrames() const { return currentFrame < remoteReceived ? currentFrame : remoteReceived; }
+    const Arena& board() const { return arena; }
+    const RollbackStats& stats() const { return sessionStats; }
+    // A correction could not be applied; the board is wrong for good.
+    bool desynced() const { return lostSync; }
+
+    // Hash of the board's state, for checking that two peers agree.
+    uint64_t checksum() const;
+
+private:
+    // Steps the board through `frame` with the local input and the remote
+    // input or guess, keeping a copy of the board from before.
+    void simulate(uint64_t frame);
+    uint8_t remoteInput(uint64_t frame) const;
+
+    int local;
+    int remote;
+    int inputDelay;
+    int maxRollback;
+    Arena arena;
+    std::vector<Arena> history; // board before frame f in history[f % size]
+
+    uint64_t currentFrame = 0;
+    uint8_t localInputs[INPUT_WINDOW];
+    uint8_t remoteInputs[INPUT_WINDOW];
+    uint64_t remoteFrames[INPUT_WINDOW]; // which frame remoteInputs[i] belongs to, plus one; 0 for none
+    uint8_t guesses[INPUT_WINDOW];       // remote input each simulated frame used
+    uint64_t remoteReceived;             // remote inputs for frames below this have all arrived
+    uint64_t peerAcked;                  // the peer has all our inputs for frames below this
+    uint64_t rollbackFrom = UINT64_MAX;  // earliest frame simulated with a wrong guess
+    bool lostSync = false;
+
+    RollbackStats sessionStats;
+};
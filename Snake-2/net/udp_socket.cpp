@@ -0,0 +1,109 @@
+#include "udp_socket.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+static const uintptr_t NO_SOCKET = ~(uintptr_t)0;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+static const int NO_SOCKET = -1;
+#endif
+
+#include <cstring>
+
+#ifdef _WIN32
+// Winsock needs starting once per process before any other call.
+static bool startNetworking() {
+    static bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+#else
+static bool startNetworking() { return true; }
+#endif
+
+static sockaddr_in toSockaddr(const NetAddress& address) {
+    sockaddr_in result;
+    memset(&result, 0, sizeof(result));
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = htonl(address.ip);
+    result.sin_port = htons(address.port);
+    return result;
+}
+
+bool resolveAddress(const char* host, uint16_t port, NetAddress& address) {
+    if (!startNetworking()) return false;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || found == nullptr) return false;
+    address.ip = ntohl(((sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    address.port = port;
+    freeaddrinfo(found);
+    return true;
+}
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+    if (!startNetworking()) return false;
+    handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == NO_SOCKET) return false;
+
+    NetAddress any;
+    any.port = port;
+    sockaddr_in local = toSockaddr(any);
+    socklen_t length = sizeof(local);
+    if (bind(handle, (sockaddr*)&local, sizeof(local)) != 0 || getsockname(handle, (sockaddr*)&local, &length) != 0) {
+        close();
+        return false;
+    }
+    boundPort = ntohs(local.sin_port);
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    bool ok = ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+    bool ok = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    if (!ok) close();
+    return ok;
+}
+
+void UdpSocket::close() {
+    if (handle == NO_SOCKET) return;
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    ::close(handle);
+#endif
+    handle = NO_SOCKET;
+    boundPort = 0;
+}
+
+bool UdpSocket::sendTo(const NetAddress& to, const void* data, size_t size) {
+    sockaddr_in address = toSockaddr(to);
+    return sendto(handle, (const char*)data, (int)size, 0, (sockaddr*)&address, sizeof(address)) == (int)size;
+}
+
+int UdpSocket::receive(void* buffer, size_t capacity, NetAddress& from) {
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int received = (int)recvfrom(handle, (char*)buffer, (int)capacity, 0, (sockaddr*)&address, &length);
+    if (received < 0) return -1;
+    from.ip = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+    return received;
+}
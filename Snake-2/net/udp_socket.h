@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// IPv4 address and port, both in host byte order.
+struct NetAddress {
+    uint32_t ip = 0;
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+};
+
+// Parses "a.b.c.d" or looks the name up; false if it can't be resolved.
+bool resolveAddress(const char* host, uint16_t port, NetAddress& address);
+
+// Non-blocking UDP socket over BSD sockets / Winsock.
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { close(); }
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // Binds to every interface; port 0 picks a free one (see port()).
+    bool open(uint16_t port);
+    void close();
+
+    uint16_t port() const { return boundPort; }
+
+    bool sendTo(const NetAddress& to, const void* data, size_t size);
+
+    // Returns the datagram size, or -1 when nothing is waiting.
+    int receive(void* buffer, size_t capacity, NetAddress& from);
+
+private:
+#ifdef _WIN32
+    uintptr_t handle = ~(uintptr_t)0;
+#else
+    int handle = -1;
+#endif
+    uint16_t boundPort = 0;
+};
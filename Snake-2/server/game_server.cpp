@@ -0,0 +1,495 @@
+#include "game_server.h"
+
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sched.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "../core/input_queue.h"
+#include "protocol.h"
+
+namespace {
+
+uint64_t clockNs(clockid_t clock) {
+    timespec now;
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// A client is its address plus the id it put in its messages.
+struct ClientKey {
+    uint64_t address; // ip << 16 | port
+    uint32_t id;
+
+    bool operator==(const ClientKey& other) const { return address == other.address && id == other.id; }
+};
+
+struct ClientKeyHash {
+    size_t operator()(const ClientKey& key) const {
+        uint64_t x = key.address * 0x9E3779B97F4A7C15ull ^ key.id;
+        return (size_t)(x ^ (x >> 29));
+    }
+};
+
+ClientKey keyOf(const sockaddr_in& address, uint32_t id) {
+    return { (uint64_t)ntohl(address.sin_addr.s_addr) << 16 | ntohs(address.sin_port), id };
+}
+
+struct Client {
+    sockaddr_in address;
+    uint32_t id;
+    uint32_t room;
+    uint64_t lastHeardNs;
+    bool needsKeyframe;
+};
+
+struct Room {
+    GameState game;
+    InputQueue inputs;
+    std::vector<ClientKey> members; // members[0] plays
+};
+
+} // namespace
+
+struct GameServer::Core {
+    int index = 0;
+    int coreCount = 1;
+    const ServerConfig* config = nullptr;
+    int socketFd = -1;
+    int epollFd = -1;
+    int timerFd = -1;
+    int stopFd = -1;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+    uint64_t cpuAtStart = 0;
+    uint64_t startNs = 0;
+
+    std::unordered_map<ClientKey, Client, ClientKeyHash> clients;
+    std::unordered_map<uint32_t, Room> rooms;
+
+    // Outgoing messages of one tick, sent with sendmmsg() in batches.
+    // Message i is outBytes[outEnds[i - 1], outEnds[i]).
+    std::vector<uint8_t> outBytes;
+    std::vector<size_t> outEnds;
+    std::vector<sockaddr_in> outAddresses;
+
+    mutable std::mutex statsMutex;
+    ServerStats stats;
+    ServerStats local; // updated by the thread, copied to stats once per tick
+
+    bool open(uint16_t port);
+    void close();
+    void run();
+    void receive();
+    void handle(const uint8_t* data, int size, const sockaddr_in& from, uint64_t now);
+    void removeClient(const ClientKey& key);
+    void tick(uint64_t scheduledNs, uint64_t expirations);
+    uint8_t* queueMessage(const Client& client, size_t size);
+    void queueState(const Client& client, uint32_t tickNumber, int result, const GameState& game);
+    void queueKeyframe(const Client& client, uint32_t tickNumber, int result, const GameState& game);
+    void flushStates();
+    void send(const sockaddr_in& to, const uint8_t* data, size_t size);
+};
+
+bool GameServer::Core::open(uint16_t port) {
+    socketFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (socketFd < 0) return false;
+    int size = 4 << 20; // room for a tick's worth of inputs from thousands of clients
+    setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(socketFd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(socketFd, (sockaddr*)&address, sizeof(address)) != 0) return false;
+
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    stopFd = eventfd(0, EFD_NONBLOCK);
+    epollFd = epoll_create1(0);
+    if (timerFd < 0 || stopFd < 0 || epollFd < 0) return false;
+
+    for (int fd : { socketFd, timerFd, stopFd }) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+    }
+    return true;
+}
+
+void GameServer::Core::close() {
+    for (int* fd : { &socketFd, &epollFd, &timerFd, &stopFd }) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+}
+
+void GameServer::Core::send(const sockaddr_in& to, const uint8_t* data, size_t size) {
+    sendto(socketFd, data, size, 0, (const sockaddr*)&to, sizeof(to));
+    local.packetsOut++;
+}
+
+void GameServer::Core::removeClient(const ClientKey& key) {
+    auto found = clients.find(key);
+    if (found == clients.end()) return;
+    auto room = rooms.find(found->second.room);
+    if (room != rooms.end()) {
+        std::vector<ClientKey>& members = room->second.members;
+        for (size_t i = 0; i < members.size(); i++) {
+            if (members[i] == key) {
+                members.erase(members.begin() + i); // the next member, if any, takes over playing
+                break;
+            }
+        }
+        if (members.empty()) rooms.erase(room);
+    }
+    clients.erase(found);
+}
+
+void GameServer::Core::handle(const uint8_t* data, int size, const sockaddr_in& from, uint64_t now) {
+    if (size < 5) return;
+    uint32_t id = getU32(data + 1);
+    ClientKey key = keyOf(from, id);
+    uint8_t reply[16];
+
+    if (data[0] == MSG_JOIN && size >= 9) {
+        uint32_t roomId = getU32(data + 5);
+        reply[0] = 0;
+        putU32(reply + 1, id);
+        putU32(reply + 5, roomId);
+        if ((int)(roomId % coreCount) != index) {
+            reply[0] = MSG_REDIRECT;
+            putU16(reply + 9, (uint16_t)(config->basePort + roomId % coreCount));
+            send(from, reply, 11);
+            return;
+        }
+
+        removeClient(key); // joining again moves the client
+        auto created = rooms.emplace(roomId, Room());
+        Room& room = created.first->second;
+        if (created.second) newGame(room.game, config->game, config->seed ^ ((uint64_t)roomId * 0x9E3779B97F4A7C15ull));
+        room.members.push_back(key);
+        clients[key] = { from, id, roomId, now, true };
+
+        reply[0] = MSG_WELCOME;
+        putU16(reply + 9, (uint16_t)config->game.width);
+        putU16(reply + 11, (uint16_t)config->game.height);
+        send(from, reply, 13);
+        return;
+    }
+
+    auto found = clients.find(key);
+    if (found == clients.end()) return;
+    found->second.lastHeardNs = now;
+
+    if (data[0] == MSG_INPUT && size >= 6 && data[5] < 4) {
+        auto room = rooms.find(found->second.room);
+        if (room != rooms.end() && room->second.members[0] == key) {
+            room->second.inputs.push(Direction(data[5]), room->second.game.direction, now);
+        }
+    }
+    else if (data[0] == MSG_LEAVE) {
+        removeClient(key);
+    }
+}
+
+void GameServer::Core::receive() {
+    const int BATCH = 64;
+    uint8_t buffers[BATCH][64];
+    sockaddr_in addresses[BATCH];
+    iovec vectors[BATCH];
+    mmsghdr messages[BATCH];
+    for (;;) {
+        for (int i = 0; i < BATCH; i++) {
+            vectors[i] = { buffers[i], sizeof(buffers[i]) };
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int received = recvmmsg(socketFd, messages, BATCH, MSG_DONTWAIT, nullptr);
+        if (received <= 0) return;
+        uint64_t now = clockNs(CLOCK_MONOTONIC);
+        for (int i = 0; i < received; i++) handle(buffers[i], (int)messages[i].msg_len, addresses[i], now);
+        local.packetsIn += received;
+        if (received < BATCH) return;
+    }
+}
+
+uint8_t* GameServer::Core::queueMessage(const Client& client, size_t size) {
+    size_t at = outBytes.size();
+    outBytes.resize(at + size);
+    outEnds.push_back(at + size);
+    outAddresses.push_back(client.address);
+    return &outBytes[at];
+}
+
+void GameServer::Core::queueState(const Client& client, uint32_t tickNumber, int result, const GameState& game) {
+    uint8_t* state = queueMessage(client, STATE_SIZE);
+    Point head = game.segments.front();
+    state[0] = MSG_STATE;
+    putU32(state + 1, client.id);
+    putU32(state + 5, tickNumber);
+    state[9] = (uint8_t)result;
+    putU16(state + 10, (uint16_t)head.x);
+    putU16(state + 12, (uint16_t)head.y);
+    state[14] = (uint8_t)game.direction;
+    putU16(state + 15, (uint16_t)game.food.x);
+    putU16(state + 17, (uint16_t)game.food.y);
+    putU32(state + 19, (uint32_t)game.segments.size());
+}
+
+void GameServer::Core::queueKeyframe(const Client& client, uint32_t tickNumber, int result, const GameState& game) {
+    size_t length = game.segments.size();
+    size_t first = 0;
+    do {
+        size_t count = length - first < (size_t)KEYFRAME_POINTS ? length - first : (size_t)KEYFRAME_POINTS;
+        uint8_t* frame = queueMessage(client, KEYFRAME_HEADER + count * 4);
+        frame[0] = MSG_KEYFRAME;
+        putU32(frame + 1, client.id);
+        putU32(frame + 5, tickNumber);
+        frame[9] = (uint8_t)result;
+        frame[10] = (uint8_t)game.direction;
+        putU16(frame + 11, (uint16_t)game.food.x);
+        putU16(frame + 13, (uint16_t)game.food.y);
+        putU32(frame + 15, (uint32_t)length);
+        putU32(frame + 19, (uint32_t)first);
+        putU16(frame + 23, (uint16_t)count);
+        uint8_t* out = frame + KEYFRAME_HEADER;
+        for (size_t i = 0; i < count; i++, out += 4) {
+            Point p = game.segments[first + i];
+            putU16(out, (uint16_t)p.x);
+            putU16(out + 2, (uint16_t)p.y);
+        }
+        first += count;
+    } while (first < length);
+}
+
+void GameServer::Core::flushStates() {
+    const size_t BATCH = 256;
+    iovec vectors[BATCH];
+    mmsghdr messages[BATCH];
+    size_t total = outAddresses.size();
+    for (size_t first = 0; first < total; first += BATCH) {
+        size_t count = total - first < BATCH ? total - first : BATCH;
+        for (size_t i = 0; i < count; i++) {
+            size_t begin = first + i > 0 ? outEnds[first + i - 1] : 0;
+            vectors[i] = { &outBytes[begin], outEnds[first + i] - begin };
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_name = &outAddresses[first + i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(socketFd, messages, (unsigned)count, 0);
+        if (sent > 0) local.packetsOut += sent;
+    }
+    outBytes.clear();
+    outEnds.clear();
+    outAddresses.clear();
+}
+
+void GameServer::Core::tick(uint64_t scheduledNs, uint64_t expirations) {
+    uint64_t start = clockNs(CLOCK_MONOTONIC);
+    uint64_t cpuStart = clockNs(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t late = start > scheduledNs ? (start - scheduledNs) / 1000 : 0;
+    local.ticks++;
+    local.missedTicks += expirations - 1;
+    local.jitterTotalUs += late;
+    if (late > local.jitterMaxUs) local.jitterMaxUs = late;
+
+    for (auto& entry : rooms) {
+        Room& room = entry.second;
+        InputQueue::Entry input;
+        if (room.inputs.pop(input)) turn(room.game, input.direction);
+        int result = updateSnake(room.game);
+        bool restarted = isGameOver(result);
+        if (restarted) {
+            initializeGame(room.game);
+            room.inputs.clear();
+        }
+        // Rooms take their periodic keyframes on different ticks so they
+        // do not all land on the same one.
+        bool keyframe = restarted || (room.game.tick + entry.first) % (uint64_t)config->keyframeTicks == 0;
+        for (const ClientKey& member : room.members) {
+            Client& client = clients[member];
+            if (keyframe || client.needsKeyframe) {
+                queueKeyframe(client, (uint32_t)room.game.tick, result, room.game);
+                client.needsKeyframe = false;
+            }
+            else {
+                queueState(client, (uint32_t)room.game.tick, result, room.game);
+            }
+        }
+    }
+    local.roomTicks += rooms.size();
+    flushStates();
+
+    // Drop clients that went quiet, about once a second.
+    if (local.ticks % (uint64_t)(config->tickRate + 1) == 0) {
+        uint64_t cutoff = start - (uint64_t)config->clientTimeoutMs * 1000000ull;
+        std::vector<ClientKey> stale;
+        for (const auto& entry : clients) {
+            if (entry.second.lastHeardNs < cutoff) stale.push_back(entry.first);
+        }
+        for (const ClientKey& key : stale) removeClient(key);
+    }
+
+    uint64_t cpuEnd = clockNs(CLOCK_THREAD_CPUTIME_ID);
+    local.tickCpuNs += cpuEnd - cpuStart;
+    local.threadCpuNs = cpuEnd - cpuAtStart;
+    local.elapsedNs = clockNs(CLOCK_MONOTONIC) - startNs;
+    local.rooms = (uint32_t)rooms.size();
+    local.clients = (uint32_t)clients.size();
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats = local;
+}
+
+void GameServer::Core::run() {
+    uint64_t periodNs = (uint64_t)(1e9 / config->tickRate);
+    uint64_t first = clockNs(CLOCK_MONOTONIC) + periodNs;
+    itimerspec timer;
+    timer.it_value = { (time_t)(first / 1000000000ull), (long)(first % 1000000000ull) };
+    timer.it_interval = { (time_t)(periodNs / 1000000000ull), (long)(periodNs % 1000000000ull) };
+    timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &timer, nullptr);
+    cpuAtStart = clockNs(CLOCK_THREAD_CPUTIME_ID);
+    startNs = clockNs(CLOCK_MONOTONIC);
+    uint64_t ticksScheduled = 0;
+
+    // stopFd wakes the loop at once; the timeout only matters if writing
+    // to it failed, and bounds how long stop() then waits.
+    epoll_event events[8];
+    while (!stopping.load(std::memory_order_acquire)) {
+        int ready = epoll_wait(epollFd, events, 8, 100);
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == stopFd) return;
+            if (fd == socketFd) {
+                receive();
+            }
+            else if (fd == timerFd) {
+                uint64_t expirations = 0;
+                if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0) continue;
+                ticksScheduled += expirations;
+                tick(first + (ticksScheduled - 1) * periodNs, expirations);
+            }
+        }
+    }
+}
+
+GameServer::GameServer(const ServerConfig& config) : config(config) {
+    if (this->config.cores <= 0) this->config.cores = (int)std::thread::hardware_concurrency();
+    if (this->config.cores <= 0) this->config.cores = 1;
+    if (this->config.keyframeTicks <= 0) this->config.keyframeTicks = 1;
+}
+
+GameServer::~GameServer() {
+    stop();
+}
+
+bool servableBoard(const GameConfig& game) {
+    return game.width >= 1 && game.width <= MAX_BOARD_SIDE && game.height >= 1 && game.height <= MAX_BOARD_SIDE &&
+        game.initialLength >= 1 && game.initialLength <= game.height;
+}
+
+bool GameServer::start() {
+    if (!servableBoard(config.game)) return false;
+    for (int i = 0; i < config.cores; i++) {
+        std::unique_ptr<Core> core(new Core());
+        core->index = i;
+        core->coreCount = config.cores;
+        core->config = &config;
+        if (!core->open((uint16_t)(config.basePort + i))) {
+            core->close();
+            stop();
+            return false;
+        }
+        coreList.push_back(std::move(core));
+    }
+    // Core i is pinned to the i-th CPU this process may run on, so its
+    // rooms, sockets and caches stay on one CPU. With more cores than CPUs
+    // they wrap around.
+    cpu_set_t allowed;
+    std::vector<int> cpus;
+    if (config.pinThreads && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+    }
+    for (auto& core : coreList) {
+        core->thread = std::thread(&Core::run, core.get());
+        if (cpus.empty()) continue;
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpus[core->index % cpus.size()], &one);
+        pthread_setaffinity_np(core->thread.native_handle(), sizeof(one), &one); // unpinned is slower, not wrong
+    }
+    return true;
+}
+
+void GameServer::stop() {
+    for (auto& core : coreList) {
+        core->stopping.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        ssize_t written = write(core->stopFd, &one, sizeof(one)); // if this fails the loop still sees the flag
+        (void)written;
+    }
+    for (auto& core : coreList) {
+        if (core->thread.joinable()) core->thread.join();
+        core->close();
+    }
+    coreList.clear();
+}
+
+ServerStats GameServer::stats(int core) const {
+    std::lock_guard<std::mutex> lock(coreList[core]->statsMutex);
+    return coreList[core]->stats;
+}
+
+void printServerStats(const GameServer& server, std::ostream& out) {
+    ServerStats total;
+    out << std::fixed << std::setprecision(1);
+    out << "core  rooms  clients  ticks  missed  late avg/max us  tick us  cpu us/room-tick  busy %" << std::endl;
+    for (int i = 0; i < server.cores(); i++) {
+        ServerStats s = server.stats(i);
+        uint64_t ticks = s.ticks > 0 ? s.ticks : 1;
+        uint64_t roomTicks = s.roomTicks > 0 ? s.roomTicks : 1;
+        double busy = s.elapsedNs > 0 ? 100.0 * s.threadCpuNs / s.elapsedNs : 0;
+        std::ostringstream late;
+        late << std::fixed << std::setprecision(1) << (double)s.jitterTotalUs / ticks << "/" << s.jitterMaxUs;
+        out << std::setw(4) << i << std::setw(7) << s.rooms << std::setw(9) << s.clients << std::setw(7) << s.ticks
+            << std::setw(8) << s.missedTicks << std::setw(17) << late.str() << std::setw(9) << s.tickCpuNs / 1000.0 / ticks
+            << std::setw(18) << s.threadCpuNs / 1000.0 / roomTicks << std::setw(8) << busy << std::endl;
+
+        total.rooms += s.rooms;
+        total.clients += s.clients;
+        total.ticks += s.ticks;
+        total.missedTicks += s.missedTicks;
+        total.roomTicks += s.roomTicks;
+        total.threadCpuNs += s.threadCpuNs;
+        total.packetsIn += s.packetsIn;
+        total.packetsOut += s.packetsOut;
+        if (s.jitterMaxUs > total.jitterMaxUs) total.jitterMaxUs = s.jitterMaxUs;
+    }
+    out << "total: " << total.rooms << " rooms, " << total.clients << " clients, " << total.missedTicks
+        << " missed ticks, max lateness " << total.jitterMaxUs << " us, "
+        << (total.roomTicks > 0 ? total.threadCpuNs / 1000.0 / total.roomTicks : 0) << " us CPU per room-tick, "
+        << total.packetsIn << " packets in, " << total.packetsOut << " out" << std::endl;
+    out << std::defaultfloat;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "../core/game.h"
+
+struct ServerConfig {
+    uint16_t basePort = 40500; // core i listens on basePort + i
+    int cores = 0;             // 0: one per hardware thread
+    bool pinThreads = true;    // pin core i's thread to one CPU
+    double tickRate = 1000.0 / 130;
+    GameConfig game;
+    int clientTimeoutMs = 10000;
+    int keyframeTicks = 64;    // a room's members get its whole body this often
+    uint64_t seed = 1;
+};
+
+// One core's counters since start().
+struct ServerStats {
+    uint64_t ticks = 0;
+    uint64_t missedTicks = 0;   // timer expirations that came while a tick was still running
+    uint64_t jitterTotalUs = 0; // how late each tick started, summed
+    uint64_t jitterMaxUs = 0;
+    uint64_t tickCpuNs = 0;     // stepping rooms and sending states
+    uint64_t threadCpuNs = 0;   // everything the core's thread did, receiving included
+    uint64_t elapsedNs = 0;     // wall time the counters cover
+    uint64_t roomTicks = 0;     // rooms stepped, summed over ticks
+    uint64_t packetsIn = 0;
+    uint64_t packetsOut = 0;
+    uint32_t rooms = 0;
+    uint32_t clients = 0;
+};
+
+// Headless authoritative server for many single-snake rooms (Linux only).
+// Every core runs a thread of its own, pinned to a CPU, with its own UDP
+// port, epoll loop, timerfd tick scheduler and rooms, so cores share
+// nothing while running.
+// On each tick a core steps all its rooms with updateSnake(), applying at
+// most one queued turn per room, and sends every member a 23-byte delta, or
+// a keyframe with the whole body when it joined, the game restarted or the
+// room is due one. See protocol.h for the messages.
+class GameServer {
+public:
+    explicit GameServer(const ServerConfig& config);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Opens every core's port and starts the threads. Fails without opening
+    // anything if servableBoard() rejects the board.
+    bool start();
+    void stop();
+
+    int cores() const { return (int)coreList.size(); }
+    ServerStats stats(int core) const;
+
+    struct Core;
+
+private:
+    ServerConfig config;
+    std::vector<std::unique_ptr<Core>> coreList;
+};
+
+// Boards the server can run: sides 1..MAX_BOARD_SIDE, so states fit their
+// 16-bit coordinates, and at least initialLength cells tall, so the
+// starting snake fits.
+bool servableBoard(const GameConfig& game);
+
+// One line per core plus a total: rooms, clients, tick lateness, and CPU
+// time per room per tick.
+void printServerStats(const GameServer& server, std::ostream& out);
@@ -0,0 +1,336 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/rng.h"
+#include "game_server.h"
+#include "protocol.h"
+
+// SnakeLoad [--clients N] [--sockets N] [--per-room N] [--seconds S]
+//           [--turn-ms MS] [--server HOST] [--port BASE] [--cores N] [--tick-rate HZ]
+//
+// Simulates many clients against SnakeServer on localhost and reports how
+// evenly their states arrive. Each client rebuilds its room's snake from the
+// keyframes and deltas, so a broken stream shows up as lost sync or body
+// mismatches. Without --server it starts a server in this
+// process first and prints its per-core tick lateness and CPU per room too.
+// Clients share --sockets sockets, told apart by the id in each message.
+//
+// Linux only. Build from the Snake-2 directory with
+//   g++ -std=c++17 -O2 server/load_main.cpp server/game_server.cpp core/game.cpp -o SnakeLoad -lpthread
+
+namespace {
+
+struct LoadOptions {
+    int clients = 10000;
+    int sockets = 100;
+    int perRoom = 1;
+    int seconds = 10;
+    int turnMs = 500;      // each client turns about this often
+    std::string server;    // empty: run one in-process
+    ServerConfig serverConfig;
+};
+
+struct SimClient {
+    uint16_t port = 0; // server port for this client's room
+    bool joined = false;
+    uint64_t lastStateNs = 0;
+    uint64_t lastJoinNs = 0;
+
+    // The snake as rebuilt from keyframes and deltas, valid when synced.
+    std::deque<Point> body;
+    uint32_t tick = 0;
+    bool synced = false;
+    // Keyframe being put together from its datagrams.
+    std::vector<Point> pending;
+    uint32_t pendingTick = 0;
+    uint32_t pendingHave = 0;
+};
+
+struct StreamCounts {
+    uint64_t keyframes = 0;  // complete keyframes
+    uint64_t deltas = 0;     // deltas applied
+    uint64_t syncLost = 0;   // a tick went missing
+    uint64_t waiting = 0;    // deltas thrown away while waiting for a keyframe
+    uint64_t mismatches = 0; // deltas whose length did not fit the body
+};
+
+void applyKeyframe(SimClient& client, const uint8_t* data, int size, StreamCounts& counts) {
+    uint32_t tick = getU32(data + 5);
+    uint32_t length = getU32(data + 15);
+    uint32_t first = getU32(data + 19);
+    uint32_t count = getU16(data + 23);
+    if (size < KEYFRAME_HEADER + (int)count * 4 || first + count > length) return;
+    if (client.pendingTick != tick || client.pending.size() != length) {
+        client.pending.assign(length, Point{ 0, 0 });
+        client.pendingTick = tick;
+        client.pendingHave = 0;
+    }
+    const uint8_t* in = data + KEYFRAME_HEADER;
+    for (uint32_t i = 0; i < count; i++, in += 4) client.pending[first + i] = { getU16(in), getU16(in + 2) };
+    client.pendingHave += count;
+    if (client.pendingHave < length) return;
+    client.body.assign(client.pending.begin(), client.pending.end());
+    client.tick = tick;
+    client.synced = true;
+    client.pendingHave = 0;
+    counts.keyframes++;
+}
+
+void applyDelta(SimClient& client, const uint8_t* data, StreamCounts& counts) {
+    uint32_t tick = getU32(data + 5);
+    if (!client.synced) {
+        counts.waiting++;
+        return;
+    }
+    if (tick != client.tick + 1) {
+        client.synced = false;
+        counts.syncLost++;
+        counts.waiting++;
+        return;
+    }
+    uint32_t length = getU32(data + 19);
+    client.body.push_front({ getU16(data + 10), getU16(data + 12) });
+    while (client.body.size() > length) client.body.pop_back();
+    client.tick = tick;
+    counts.deltas++;
+    if (client.body.size() != length) {
+        client.synced = false;
+        counts.mismatches++;
+    }
+}
+
+uint64_t nowNs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// Gaps between consecutive states of the same client, compared with the
+// tick period: 100 us buckets up to one second.
+struct JitterHistogram {
+    static const int BUCKETS = 10000;
+    std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKETS + 1, 0);
+    uint64_t samples = 0;
+    double totalUs = 0;
+    double maxUs = 0;
+
+    void add(double deviationUs) {
+        int bucket = (int)(deviationUs / 100);
+        counts[bucket < BUCKETS ? bucket : BUCKETS]++;
+        samples++;
+        totalUs += deviationUs;
+        if (deviationUs > maxUs) maxUs = deviationUs;
+    }
+
+    double percentileUs(double p) const {
+        uint64_t wanted = (uint64_t)(samples * p);
+        uint64_t seen = 0;
+        for (int i = 0; i <= BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > wanted) return (i + 1) * 100.0 < maxUs ? (i + 1) * 100.0 : maxUs;
+        }
+        return BUCKETS * 100.0;
+    }
+};
+
+bool parseOptions(int argc, char* argv[], LoadOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--clients") == 0 && hasValue) options.clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sockets") == 0 && hasValue) options.sockets = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--per-room") == 0 && hasValue) options.perRoom = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue) options.seconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--turn-ms") == 0 && hasValue) options.turnMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--server") == 0 && hasValue) options.server = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && hasValue) options.serverConfig.basePort = (uint16_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cores") == 0 && hasValue) options.serverConfig.cores = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && hasValue) options.serverConfig.tickRate = atof(argv[++i]);
+        else return false;
+    }
+    return options.clients > 0 && options.sockets > 0 && options.perRoom > 0 && options.seconds > 0 &&
+        options.turnMs > 0 && options.serverConfig.tickRate > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "usage: SnakeLoad [--clients N] [--sockets N] [--per-room N] [--seconds S] [--turn-ms MS]" << std::endl;
+        std::cout << "                 [--server HOST] [--port BASE] [--cores N] [--tick-rate HZ]" << std::endl;
+        return 1;
+    }
+    if (options.sockets > options.clients) options.sockets = options.clients;
+
+    std::unique_ptr<GameServer> server;
+    if (options.server.empty()) {
+        server.reset(new GameServer(options.serverConfig));
+        if (!server->start()) {
+            std::cout << "Cannot start a server on ports " << options.serverConfig.basePort << " and up" << std::endl;
+            return 1;
+        }
+        options.server = "127.0.0.1";
+    }
+    in_addr serverIp;
+    if (inet_pton(AF_INET, options.server.c_str(), &serverIp) != 1) {
+        std::cout << "--server needs an IPv4 address" << std::endl;
+        return 1;
+    }
+
+    int epollFd = epoll_create1(0);
+    std::vector<int> sockets;
+    for (int i = 0; i < options.sockets; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        int size = 1 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u32 = (uint32_t)i;
+        if (fd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            std::cout << "Cannot open " << options.sockets << " sockets" << std::endl;
+            return 1;
+        }
+        sockets.push_back(fd);
+    }
+
+    std::vector<SimClient> clients(options.clients);
+    for (SimClient& client : clients) client.port = options.serverConfig.basePort;
+    auto sendTo = [&](int client, const uint8_t* data, size_t size) {
+        sockaddr_in to;
+        memset(&to, 0, sizeof(to));
+        to.sin_family = AF_INET;
+        to.sin_addr = serverIp;
+        to.sin_port = htons(clients[client].port);
+        sendto(sockets[client % options.sockets], data, size, 0, (sockaddr*)&to, sizeof(to));
+    };
+    auto sendJoin = [&](int client, uint64_t now) {
+        uint8_t join[9] = { MSG_JOIN };
+        putU32(join + 1, (uint32_t)client);
+        putU32(join + 5, (uint32_t)(client / options.perRoom));
+        sendTo(client, join, sizeof(join));
+        clients[client].lastJoinNs = now;
+    };
+
+    const double periodUs = 1e6 / options.serverConfig.tickRate;
+    JitterHistogram jitter;
+    uint64_t states = 0;
+    StreamCounts stream;
+    int joined = 0;
+    Rng rng(7);
+
+    const uint64_t start = nowNs();
+    const uint64_t end = start + (uint64_t)options.seconds * 1000000000ull;
+    const uint64_t stepNs = 10000000; // inputs and join retries every 10 ms
+    uint64_t nextStep = start;
+    int nextJoin = 0;
+    uint64_t measureFrom = 0; // set once every client is in, so joining does not count
+    uint64_t statesMeasured = 0;
+
+    epoll_event events[64];
+    uint8_t buffer[KEYFRAME_HEADER + KEYFRAME_POINTS * 4];
+    while (nowNs() < end) {
+        int ready = epoll_wait(epollFd, events, 64, 2);
+        uint64_t now = nowNs();
+        for (int e = 0; e < ready; e++) {
+            int fd = sockets[events[e].data.u32];
+            sockaddr_in from;
+            socklen_t length = sizeof(from);
+            int size;
+            while ((size = (int)recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&from, &length)) >= 5) {
+                uint32_t id = getU32(buffer + 1);
+                if (id >= (uint32_t)options.clients) continue;
+                SimClient& client = clients[id];
+                if (buffer[0] == MSG_WELCOME && !client.joined) {
+                    client.joined = true;
+                    joined++;
+                    if (joined == options.clients) measureFrom = now;
+                }
+                else if (buffer[0] == MSG_REDIRECT && size >= 11) {
+                    client.port = getU16(buffer + 9);
+                    sendJoin((int)id, now);
+                }
+                else if ((buffer[0] == MSG_STATE && size >= STATE_SIZE) || (buffer[0] == MSG_KEYFRAME && size >= KEYFRAME_HEADER)) {
+                    bool keyframe = buffer[0] == MSG_KEYFRAME;
+                    if (keyframe) applyKeyframe(client, buffer, size, stream);
+                    else applyDelta(client, buffer, stream);
+                    // A keyframe's tick counts once, on its first part.
+                    if (!keyframe || getU32(buffer + 19) == 0) {
+                        states++;
+                        if (measureFrom != 0) {
+                            statesMeasured++;
+                            if (client.lastStateNs >= measureFrom) {
+                                double gapUs = (now - client.lastStateNs) / 1000.0;
+                                jitter.add(gapUs > periodUs ? gapUs - periodUs : periodUs - gapUs);
+                            }
+                        }
+                        client.lastStateNs = now;
+                    }
+                }
+                length = sizeof(from);
+            }
+        }
+
+        if (now < nextStep) continue;
+        nextStep += stepNs;
+
+        // Join in slices rather than all at once so the server's receive
+        // buffers are not flooded; retry joins that got no answer.
+        for (int n = 0; n < 2000 && nextJoin < options.clients; n++) sendJoin(nextJoin++, now);
+        for (int i = 0; i < nextJoin && joined < options.clients; i++) {
+            if (!clients[i].joined && now - clients[i].lastJoinNs > 500000000ull) sendJoin(i, now);
+        }
+
+        // Random turns from players.
+        double turnsPerStep = (double)options.clients / options.perRoom * (stepNs / 1e6) / options.turnMs;
+        int turns = (int)turnsPerStep + (rng.below(1000) < (uint32_t)((turnsPerStep - (int)turnsPerStep) * 1000) ? 1 : 0);
+        for (int t = 0; t < turns; t++) {
+            int client = (int)rng.below((uint32_t)(options.clients / options.perRoom)) * options.perRoom;
+            if (!clients[client].joined) continue;
+            uint8_t input[6] = { MSG_INPUT };
+            putU32(input + 1, (uint32_t)client);
+            input[5] = (uint8_t)rng.below(4);
+            sendTo(client, input, sizeof(input));
+        }
+    }
+
+    for (int i = 0; i < options.clients; i++) {
+        uint8_t leave[5] = { MSG_LEAVE };
+        putU32(leave + 1, (uint32_t)i);
+        sendTo(i, leave, sizeof(leave));
+    }
+
+    double measuredSeconds = measureFrom != 0 ? (end - measureFrom) / 1e9 : 0;
+    double expected = measuredSeconds * options.serverConfig.tickRate * options.clients;
+    std::cout << joined << "/" << options.clients << " clients joined " << (options.clients + options.perRoom - 1) / options.perRoom
+        << " rooms, " << states << " states received" << std::endl;
+    if (measuredSeconds > 0) {
+        std::cout << "After everyone joined: " << statesMeasured / measuredSeconds << " states/sec of "
+            << expected / measuredSeconds << " expected (" << 100.0 * statesMeasured / expected << "% delivered)" << std::endl;
+        std::cout << "State arrival jitter (gap vs " << periodUs / 1000 << " ms tick): avg "
+            << (jitter.samples > 0 ? jitter.totalUs / jitter.samples / 1000 : 0) << " ms, p99 "
+            << jitter.percentileUs(0.99) / 1000 << " ms, max " << jitter.maxUs / 1000 << " ms" << std::endl;
+    }
+    std::cout << "Stream: " << stream.keyframes << " keyframes, " << stream.deltas << " deltas applied, sync lost "
+        << stream.syncLost << " times, " << stream.waiting << " deltas dropped waiting for a keyframe, "
+        << stream.mismatches << " body mismatches" << std::endl;
+    if (server) {
+        printServerStats(*server, std::cout);
+        server->stop();
+    }
+    for (int fd : sockets) close(fd);
+    close(epollFd);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Datagrams between SnakeServer and its clients. Integers little-endian.
+// Every message carries the sender's client id, so many clients can share
+// one socket (the load generator does).
+//
+// client -> server
+//   'J' u32 client, u32 room          join a room: first member plays, the rest watch
+//   'I' u32 client, u8 direction      queue a turn (player only)
+//   'L' u32 client                    leave
+// server -> client
+//   'W' u32 client, u32 room, u16 width, u16 height    joined
+//   'R' u32 client, u32 room, u16 port                 room lives on another port: join there
+//   'S' u32 client, u32 tick, u8 result, u16 head x, u16 head y, u8 direction,
+//       u16 food x, u16 food y, u32 length
+//       one tick: push the new head, then drop tail segments down to length
+//   'K' u32 client, u32 tick, u8 result, u8 direction, u16 food x, u16 food y,
+//       u32 length, u32 first, u16 count, count * (u16 x, u16 y)
+//       keyframe: segments first..first+count of the whole body, head first,
+//       split over as many datagrams as the body needs
+//
+// A client gets a keyframe when it joins, when its room's game restarts and
+// every keyframeTicks ticks after that; in between it applies 'S' deltas. A
+// client that sees a tick go missing drops its body and waits for the next
+// keyframe.
+//
+// Rooms are spread over the server's cores by id: room r is served on
+// base port + r % cores, and a join sent anywhere else is redirected there.
+
+const uint8_t MSG_JOIN = 'J';
+const uint8_t MSG_INPUT = 'I';
+const uint8_t MSG_LEAVE = 'L';
+const uint8_t MSG_WELCOME = 'W';
+const uint8_t MSG_REDIRECT = 'R';
+const uint8_t MSG_STATE = 'S';
+const uint8_t MSG_KEYFRAME = 'K';
+
+const int STATE_SIZE = 23;
+const int KEYFRAME_HEADER = 25;
+const int KEYFRAME_POINTS = 256; // per datagram, keeping it near 1 KB
+const int MAX_BOARD_SIDE = 65535; // coordinates go out as u16
+
+inline void putU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+inline void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+inline uint16_t getU16(const uint8_t* in) {
+    return (uint16_t)(in[0] | in[1] << 8);
+}
+
+inline uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
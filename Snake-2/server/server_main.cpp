@@ -0,0 +1,74 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "game_server.h"
+#include "protocol.h"
+
+// SnakeServer [--port BASE] [--cores N] [--tick-rate HZ] [--stats SECONDS]
+//             [--width CELLS] [--height CELLS] [--keyframe TICKS]
+//
+// Linux only (epoll, timerfd, recvmmsg/sendmmsg), so it is not part of the
+// Visual Studio solution. Build from the Snake-2 directory with
+//   g++ -std=c++17 -O2 server/server_main.cpp server/game_server.cpp core/game.cpp -o SnakeServer -lpthread
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    int statsSeconds = 5;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && hasValue) config.basePort = (uint16_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cores") == 0 && hasValue) config.cores = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && hasValue) config.tickRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--stats") == 0 && hasValue) statsSeconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--width") == 0 && hasValue) config.game.width = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--height") == 0 && hasValue) config.game.height = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--keyframe") == 0 && hasValue) config.keyframeTicks = atoi(argv[++i]);
+        else {
+            std::cout << "usage: SnakeServer [--port BASE] [--cores N] [--tick-rate HZ] [--stats SECONDS]" << std::endl;
+            std::cout << "                   [--width CELLS] [--height CELLS] [--keyframe TICKS]" << std::endl;
+            return 1;
+        }
+    }
+    if (config.tickRate <= 0 || statsSeconds < 1 || config.keyframeTicks < 1) {
+        std::cout << "tick rate, stats interval and keyframe interval must be positive" << std::endl;
+        return 1;
+    }
+    if (!servableBoard(config.game)) {
+        std::cout << "board sides must be 1 to " << MAX_BOARD_SIDE << " cells (states carry 16-bit coordinates) and the height "
+            << "at least the starting length of " << config.game.initialLength << std::endl;
+        return 1;
+    }
+
+    GameServer server(config);
+    if (!server.start()) {
+        std::cout << "Cannot open ports " << config.basePort << " and up" << std::endl;
+        return 1;
+    }
+    std::cout << "Serving on UDP ports " << config.basePort << "-" << config.basePort + server.cores() - 1
+        << " at " << config.tickRate << " Hz" << std::endl;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    int elapsed = 0;
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (++elapsed % (statsSeconds * 10) == 0) printServerStats(server, std::cout);
+    }
+    printServerStats(server, std::cout);
+    server.stop();
+    return 0;
+}
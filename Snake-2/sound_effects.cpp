@@ -0,0 +1,142 @@
+#include "sound_effects.h"
+
+static const int SFX_GROUP = 1;
+
+// Probe state, only touched by probeMix() on the audio thread while a
+// candidate buffer size is being tried.
+struct AudioProbe {
+    Uint64 bufferTicks;
+    Uint64 lastMix;
+    std::atomic<int> callbacks;
+    std::atomic<int> late;
+};
+
+static AudioProbe probe;
+
+static void SDLCALL probeMix(void*, Uint8*, int)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (probe.lastMix != 0 && now - probe.lastMix > probe.bufferTicks * 3 / 2) probe.late++;
+    probe.lastMix = now;
+    probe.callbacks++;
+}
+
+bool openAudio(AudioSettings& settings)
+{
+    const int PROBE_MS = 300;
+    const int candidates[] = { 256, 512, 1024, 2048 };
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+
+    if (settings.bufferSamples > 0) {
+        if (Mix_OpenAudio(settings.frequency, MIX_DEFAULT_FORMAT, settings.channels, settings.bufferSamples) != 0) return false;
+    }
+    else {
+        bool opened = false;
+        for (int samples : candidates) {
+            if (Mix_OpenAudio(settings.frequency, MIX_DEFAULT_FORMAT, settings.channels, samples) != 0) continue;
+
+            probe.bufferTicks = frequency * samples / settings.frequency;
+            probe.lastMix = 0;
+            probe.callbacks = 0;
+            probe.late = 0;
+            SDL_Delay(50); // let the device settle before listening
+            Mix_SetPostMix(probeMix, NULL);
+            SDL_Delay(PROBE_MS);
+            Mix_SetPostMix(NULL, NULL);
+
+            int expected = PROBE_MS * settings.frequency / samples / 1000;
+            bool stable = probe.late == 0 && probe.callbacks >= expected * 3 / 4;
+            if (stable || samples == candidates[3]) {
+                settings.bufferSamples = samples;
+                opened = true;
+                break;
+            }
+            Mix_CloseAudio();
+        }
+        if (!opened) return false;
+    }
+
+    Uint16 format;
+    Mix_QuerySpec(&settings.frequency, &format, &settings.channels);
+    return true;
+}
+
+bool SoundEffects::load(const char* const files[SFX_COUNT], const AudioSettings& settings)
+{
+    Mix_Chunk* loaded[SFX_COUNT];
+    bool ok = true;
+    for (int i = 0; i < SFX_COUNT; i++) {
+        loaded[i] = Mix_LoadWAV(files[i]);
+        if (loaded[i] == NULL) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+                "Load sound %s: %s", files[i], Mix_GetError());
+            ok = false;
+        }
+    }
+    attach(loaded, settings);
+    return ok;
+}
+
+void SoundEffects::attach(Mix_Chunk* const loaded[SFX_COUNT], const AudioSettings& settings)
+{
+    bufferTicks = SDL_GetPerformanceFrequency() * settings.bufferSamples / settings.frequency;
+    for (int i = 0; i < SFX_COUNT; i++) chunks[i] = loaded[i];
+
+    Mix_AllocateChannels(CHANNELS);
+    Mix_GroupChannels(0, CHANNELS - 1, SFX_GROUP);
+    Mix_SetPostMix(postMix, this);
+}
+
+void SoundEffects::free()
+{
+    Mix_SetPostMix(NULL, NULL);
+    Mix_HaltChannel(-1);
+    for (int i = 0; i < SFX_COUNT; i++) {
+        if (chunks[i] != NULL) Mix_FreeChunk(chunks[i]);
+        chunks[i] = NULL;
+    }
+}
+
+void SoundEffects::play(SoundEffect effect)
+{
+    if (chunks[effect] == NULL) return;
+
+    // A free channel if there is one, otherwise cut off the oldest effect.
+    int channel = Mix_GroupAvailable(SFX_GROUP);
+    if (channel == -1) channel = Mix_GroupOldest(SFX_GROUP);
+    if (channel == -1) channel = 0;
+
+    Uint64 requested = SDL_GetPerformanceCounter();
+    if (Mix_PlayChannel(channel, chunks[effect], 0) != -1) pendingPlay[channel].store(requested);
+}
+
+void SDLCALL SoundEffects::postMix(void* self, Uint8*, int)
+{
+    SoundEffects& sfx = *(SoundEffects*)self;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (sfx.lastMix != 0 && now - sfx.lastMix > sfx.bufferTicks * 3 / 2) sfx.underruns++;
+    sfx.lastMix = now;
+
+    for (int i = 0; i < CHANNELS; i++) {
+        Uint64 requested = sfx.pendingPlay[i].exchange(0);
+        if (requested == 0) continue;
+
+        Uint64 latency = now - requested;
+        sfx.measuredPlays++;
+        sfx.totalLatency += latency;
+        Uint64 max = sfx.maxLatency.load();
+        while (latency > max && !sfx.maxLatency.compare_exchange_weak(max, latency)) {}
+    }
+}
+
+SoundEffects::LatencyStats SoundEffects::latency() const
+{
+    double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+    LatencyStats stats;
+    stats.plays = measuredPlays.load();
+    stats.averageMs = stats.plays > 0 ? totalLatency.load() * msPerTick / stats.plays : 0;
+    stats.maxMs = maxLatency.load() * msPerTick;
+    stats.bufferMs = bufferTicks * msPerTick;
+    stats.underruns = underruns.load();
+    return stats;
+}
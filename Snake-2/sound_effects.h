@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+// Mixer device setup. A buffer of N samples adds N / frequency seconds before
+// anything mixed is heard, so smaller is better as long as the audio thread
+// keeps up.
+struct AudioSettings {
+    int frequency = 44100;
+    int channels = 2;
+    int bufferSamples = 0; // 0: probe for the smallest stable size
+};
+
+// Opens the mixer. With bufferSamples 0 it tries 256, 512, 1024 and 2048
+// samples in turn, listens to the mix callbacks for a moment and keeps the
+// first size whose callbacks all arrive on time. settings is updated with
+// what was actually opened.
+bool openAudio(AudioSettings& settings);
+
+enum SoundEffect { SFX_BITE, SFX_CRASH_WALL, SFX_CRASH_SELF, SFX_COUNT };
+
+// Sound effects decoded once into Mix_Chunk PCM buffers at startup and played
+// on a pool of mixer channels, so effects overlap instead of cutting each
+// other off and nothing is read or decoded from disk while playing.
+//
+// A post-mix callback on the audio thread measures the time from play() to
+// the first mix that includes the effect, and counts underruns: mix callbacks
+// that came more than half a buffer late, which the device heard as a gap.
+class SoundEffects {
+public:
+    static const int CHANNELS = 8;
+
+    // Needs openAudio() to have succeeded. files[i] is the file for effect i.
+    bool load(const char* const files[SFX_COUNT], const AudioSettings& settings);
+    // Same, for chunks decoded elsewhere (see AssetLoader). Takes ownership;
+    // NULL entries stay silent.
+    void attach(Mix_Chunk* const loaded[SFX_COUNT], const AudioSettings& settings);
+    void free();
+
+    void play(SoundEffect effect);
+
+    struct LatencyStats {
+        Uint64 plays;
+        double averageMs; // play() to first mix
+        double maxMs;
+        double bufferMs;  // mixed audio waits this long in the device buffer
+        Uint64 underruns;
+    };
+    LatencyStats latency() const;
+
+private:
+    static void SDLCALL postMix(void* self, Uint8* stream, int len);
+
+    Mix_Chunk* chunks[SFX_COUNT] = {};
+    Uint64 bufferTicks = 0; // one buffer in performance counter ticks
+
+    // Written by play() on the main thread, consumed by postMix() on the
+    // audio thread: performance counter value of the last unmeasured play
+    // per channel, 0 when none is pending.
+    std::atomic<Uint64> pendingPlay[CHANNELS] = {};
+    std::atomic<Uint64> measuredPlays{ 0 };
+    std::atomic<Uint64> totalLatency{ 0 }; // performance counter ticks
+    std::atomic<Uint64> maxLatency{ 0 };
+    std::atomic<Uint64> underruns{ 0 };
+    Uint64 lastMix = 0; // audio thread only
+};
@@ -0,0 +1,262 @@
+#include "sprite_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <SDL_image.h>
+
+SDL_Point packSprites(const std::vector<SDL_Point>& sizes, std::vector<SDL_Rect>& rects)
+{
+    const int padding = 1;
+    rects.assign(sizes.size(), SDL_Rect());
+
+    std::vector<size_t> order(sizes.size());
+    long long area = 0;
+    int widest = 0;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        order[i] = i;
+        area += (long long)(sizes[i].x + padding) * (sizes[i].y + padding);
+        widest = std::max(widest, sizes[i].x);
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a].y > sizes[b].y; });
+
+    // Aim for a roughly square atlas, but at least as wide as the widest sprite.
+    int width = std::max(widest, (int)std::ceil(std::sqrt((double)area)));
+    int x = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    int usedWidth = 0;
+    for (size_t i : order) {
+        if (x > 0 && x + sizes[i].x > width) {
+            shelfY += shelfHeight + padding;
+            x = 0;
+            shelfHeight = 0;
+        }
+        rects[i] = { x, shelfY, sizes[i].x, sizes[i].y };
+        x += sizes[i].x + padding;
+        shelfHeight = std::max(shelfHeight, sizes[i].y);
+        usedWidth = std::max(usedWidth, x - padding);
+    }
+
+    SDL_Point size = { std::max(usedWidth, 1), std::max(shelfY + shelfHeight, 1) };
+    return size;
+}
+
+std::vector<std::string> listSpriteFiles(const std::string& directory)
+{
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".png") files.push_back(entry.path().string());
+    }
+    return files;
+}
+
+std::string spriteName(const std::string& path)
+{
+    return std::filesystem::path(path).stem().string();
+}
+
+bool SpriteAtlas::buildFromDirectory(SDL_Renderer* renderer, const std::string& directory)
+{
+    std::vector<std::string> names;
+    std::vector<SDL_Surface*> images;
+    for (const std::string& file : listSpriteFiles(directory)) {
+        SDL_Surface* image = IMG_Load(file.c_str());
+        if (image == NULL) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+                "Load sprite %s", IMG_GetError());
+            continue;
+        }
+        names.push_back(spriteName(file));
+        images.push_back(image);
+    }
+
+    bool ok = !images.empty() && build(renderer, names, images);
+    for (SDL_Surface* image : images) SDL_FreeSurface(image);
+    return ok;
+}
+
+// First 32-bit format with alpha the renderer takes natively, so uploads need
+// no conversion inside SDL or the driver.
+static Uint32 nativeFormat(SDL_Renderer* renderer)
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+            Uint32 format = info.texture_formats[i];
+            if (!SDL_ISPIXELFORMAT_FOURCC(format) && SDL_BITSPERPIXEL(format) == 32 && SDL_ISPIXELFORMAT_ALPHA(format)) {
+                return format;
+            }
+        }
+    }
+    return SDL_PIXELFORMAT_ARGB8888;
+}
+
+bool SpriteAtlas::upload(SDL_Renderer* renderer, Uint32 format, int width, int height, const void* pixels, int pitch)
+{
+    atlasTexture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (atlasTexture == NULL || SDL_UpdateTexture(atlasTexture, NULL, pixels, pitch) != 0) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+            "Create atlas texture %s", SDL_GetError());
+        destroy();
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlasTexture, SDL_BLENDMODE_BLEND);
+
+    atlasSheet = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, format);
+    if (atlasSheet == NULL) {
+        destroy();
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        memcpy((Uint8*)atlasSheet->pixels + y * atlasSheet->pitch, (const Uint8*)pixels + y * pitch, (size_t)width * 4);
+    }
+    SDL_SetSurfaceBlendMode(atlasSheet, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+bool SpriteAtlas::build(SDL_Renderer* renderer, const std::vector<std::string>& names, const std::vector<SDL_Surface*>& images,
+    const char* cachePath, Uint64 cacheKey)
+{
+    destroy();
+
+    std::vector<SDL_Point> sizes;
+    for (SDL_Surface* image : images) sizes.push_back({ image->w, image->h });
+    std::vector<SDL_Rect> packed;
+    SDL_Point size = packSprites(sizes, packed);
+
+    // The sheet is composed straight in the texture's format; the blits do
+    // the only pixel conversion.
+    Uint32 format = nativeFormat(renderer);
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, size.x, size.y, 32, format);
+    if (sheet == NULL) return false;
+    SDL_FillRect(sheet, NULL, 0);
+    for (size_t i = 0; i < images.size(); i++) {
+        SDL_BlendMode mode;
+        SDL_GetSurfaceBlendMode(images[i], &mode);
+        SDL_SetSurfaceBlendMode(images[i], SDL_BLENDMODE_NONE); // copy alpha as-is
+        SDL_BlitSurface(images[i], NULL, sheet, &packed[i]);
+        SDL_SetSurfaceBlendMode(images[i], mode);
+        rects[names[i]] = packed[i];
+    }
+
+    bool ok = upload(renderer, format, sheet->w, sheet->h, sheet->pixels, sheet->pitch);
+    if (ok && cachePath != NULL) writeCache(cachePath, cacheKey, format, sheet);
+    SDL_FreeSurface(sheet);
+    return ok;
+}
+
+// Cache file, little-endian: "SNKATLS1", uint64 key, uint32 pixel format,
+// width, height, pitch, sprite count, then per sprite a uint32 name length,
+// the name and its rect as four uint32s, then height * pitch pixel bytes.
+static const char CACHE_MAGIC[8] = { 'S', 'N', 'K', 'A', 'T', 'L', 'S', '1' };
+
+void SpriteAtlas::writeCache(const char* path, Uint64 key, Uint32 format, SDL_Surface* sheet) const
+{
+    SDL_RWops* out = SDL_RWFromFile(path, "wb");
+    if (out == NULL) return;
+    SDL_RWwrite(out, CACHE_MAGIC, sizeof(CACHE_MAGIC), 1);
+    SDL_WriteLE64(out, key);
+    SDL_WriteLE32(out, format);
+    SDL_WriteLE32(out, sheet->w);
+    SDL_WriteLE32(out, sheet->h);
+    SDL_WriteLE32(out, sheet->pitch);
+    SDL_WriteLE32(out, (Uint32)rects.size());
+    for (const auto& sprite : rects) {
+        SDL_WriteLE32(out, (Uint32)sprite.first.size());
+        SDL_RWwrite(out, sprite.first.data(), 1, sprite.first.size());
+        SDL_WriteLE32(out, sprite.second.x);
+        SDL_WriteLE32(out, sprite.second.y);
+        SDL_WriteLE32(out, sprite.second.w);
+        SDL_WriteLE32(out, sprite.second.h);
+    }
+    size_t bytes = (size_t)sheet->h * sheet->pitch;
+    bool ok = SDL_RWwrite(out, sheet->pixels, 1, bytes) == bytes;
+    SDL_RWclose(out);
+    if (!ok) remove(path); // never leave a truncated cache behind
+}
+
+bool SpriteAtlas::loadCache(SDL_Renderer* renderer, const char* path, Uint64 key)
+{
+    destroy();
+    SDL_RWops* in = SDL_RWFromFile(path, "rb");
+    if (in == NULL) return false;
+
+    char magic[sizeof(CACHE_MAGIC)];
+    bool ok = SDL_RWread(in, magic, sizeof(magic), 1) == 1 && memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0
+        && SDL_ReadLE64(in) == key;
+    Uint32 format = ok ? SDL_ReadLE32(in) : 0;
+    ok = ok && format == nativeFormat(renderer);
+    int width = SDL_ReadLE32(in);
+    int height = SDL_ReadLE32(in);
+    int pitch = SDL_ReadLE32(in);
+    Uint32 count = SDL_ReadLE32(in);
+    ok = ok && width > 0 && height > 0 && width <= 16384 && height <= 16384 && pitch >= width * 4 && pitch <= width * 8;
+    for (Uint32 i = 0; ok && i < count; i++) {
+        Uint32 length = SDL_ReadLE32(in);
+        if (length == 0 || length > 4096) {
+            ok = false;
+            break;
+        }
+        std::string name(length, '\0');
+        ok = SDL_RWread(in, &name[0], length, 1) == 1;
+        SDL_Rect rect;
+        rect.x = SDL_ReadLE32(in);
+        rect.y = SDL_ReadLE32(in);
+        rect.w = SDL_ReadLE32(in);
+        rect.h = SDL_ReadLE32(in);
+        rects[name] = rect;
+    }
+    std::vector<Uint8> pixels;
+    if (ok) {
+        pixels.resize((size_t)height * pitch);
+        ok = SDL_RWread(in, pixels.data(), pixels.size(), 1) == 1;
+    }
+    SDL_RWclose(in);
+
+    if (!ok) {
+        rects.clear();
+        return false;
+    }
+    return upload(renderer, format, width, height, pixels.data(), pitch);
+}
+
+Uint64 spriteSourceHash(const std::vector<std::string>& names, const std::vector<std::string_view>& files)
+{
+    // FNV-1a over every name and file, in name order so directory listing
+    // order does not matter.
+    std::vector<size_t> order(names.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return names[a] < names[b]; });
+
+    Uint64 hash = 14695981039346656037ull;
+    auto mix = [&](const void* data, size_t size) {
+        const Uint8* bytes = (const Uint8*)data;
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    };
+    for (size_t i : order) {
+        Uint64 lengths[2] = { names[i].size(), files[i].size() };
+        mix(lengths, sizeof(lengths));
+        mix(names[i].data(), names[i].size());
+        mix(files[i].data(), files[i].size());
+    }
+    return hash;
+}
+
+void SpriteAtlas::destroy()
+{
+    if (atlasTexture != NULL) SDL_DestroyTexture(atlasTexture);
+    if (atlasSheet != NULL) SDL_FreeSurface(atlasSheet);
+    atlasTexture = NULL;
+    atlasSheet = NULL;
+    rects.clear();
+}
+
+const SDL_Rect* SpriteAtlas::find(const std::string& name) const
+{
+    auto it = rects.find(name);
+    return it == rects.end() ? NULL : &it->second;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+
+// All sprites packed into one texture, so drawing a frame never switches
+// textures however many sprites there are. Sprites are looked up by file
+// name without extension, e.g. "snake_head" for img/snake_head.png.
+class SpriteAtlas {
+public:
+    // Loads every .png in the directory and packs them.
+    bool buildFromDirectory(SDL_Renderer* renderer, const std::string& directory);
+
+    // Packs already-decoded images; names[i] belongs to images[i]. The atlas
+    // does not take ownership of the surfaces. With a cache path, the packed
+    // sheet is also saved there under cacheKey for loadCache().
+    bool build(SDL_Renderer* renderer, const std::vector<std::string>& names, const std::vector<SDL_Surface*>& images,
+        const char* cachePath = NULL, Uint64 cacheKey = 0);
+
+    // Restores an atlas saved by build(). The pixels are stored in the
+    // renderer's own texture format, so this is one file read and one
+    // SDL_UpdateTexture: no PNG decoding, no conversion. Fails if the file
+    // is missing, was saved under another key or for another pixel format.
+    bool loadCache(SDL_Renderer* renderer, const char* path, Uint64 key);
+
+    void destroy();
+
+    SDL_Texture* texture() const { return atlasTexture; }
+    // The same pixels in memory, for SpriteBatch's software path.
+    SDL_Surface* sheet() const { return atlasSheet; }
+
+    // Source rect of a sprite inside texture(), or NULL if there is no such sprite.
+    const SDL_Rect* find(const std::string& name) const;
+
+private:
+    bool upload(SDL_Renderer* renderer, Uint32 format, int width, int height, const void* pixels, int pitch);
+    void writeCache(const char* path, Uint64 key, Uint32 format, SDL_Surface* sheet) const;
+
+    SDL_Texture* atlasTexture = NULL;
+    SDL_Surface* atlasSheet = NULL;
+    std::unordered_map<std::string, SDL_Rect> rects;
+};
+
+// Paths of the .png files in a directory, i.e. what buildFromDirectory() loads.
+std::vector<std::string> listSpriteFiles(const std::string& directory);
+
+// Sprite name for an image path: the file name without extension.
+std::string spriteName(const std::string& path);
+
+// Cache key for a set of source images: changes whenever any file's name or
+// contents do. files[i] holds the encoded bytes of names[i].
+Uint64 spriteSourceHash(const std::vector<std::string>& names, const std::vector<std::string_view>& files);
+
+// Shelf packing: tallest first, left to right in rows, 1px apart so linear
+// filtering never bleeds between neighbours. Fills rects[i] for sizes[i] and
+// returns the atlas size needed.
+SDL_Point packSprites(const std::vector<SDL_Point>& sizes, std::vector<SDL_Rect>& rects);
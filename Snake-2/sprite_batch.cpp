@@ -0,0 +1,158 @@
+#include "sprite_batch.h"
+
+void SpriteBatch::begin(const SpriteAtlas& atlas)
+{
+    texture = atlas.texture();
+    SDL_QueryTexture(texture, NULL, NULL, &atlasWidth, &atlasHeight);
+    count = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    vertices.clear();
+#else
+    sheet = atlas.sheet();
+    sources.clear();
+    targets.clear();
+#endif
+}
+
+void SpriteBatch::add(const SDL_Rect& source, float x, float y, float w, float h)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    float u0 = (float)source.x / atlasWidth;
+    float v0 = (float)source.y / atlasHeight;
+    float u1 = (float)(source.x + source.w) / atlasWidth;
+    float v1 = (float)(source.y + source.h) / atlasHeight;
+    SDL_Color white = { 255, 255, 255, 255 };
+    vertices.push_back({ { x, y }, white, { u0, v0 } });
+    vertices.push_back({ { x + w, y }, white, { u1, v0 } });
+    vertices.push_back({ { x + w, y + h }, white, { u1, v1 } });
+    vertices.push_back({ { x, y + h }, white, { u0, v1 } });
+
+    // Quad indices only depend on the quad number, so they are written once
+    // and reused by every later frame.
+    if ((int)indices.size() < (count + 1) * 6) {
+        int base = count * 4;
+        int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+#else
+    sources.push_back(source);
+    SDL_Rect target = { (int)(x + 0.5f), (int)(y + 0.5f), (int)(w + 0.5f), (int)(h + 0.5f) };
+    targets.push_back(target);
+#endif
+    count++;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+
+int SpriteBatch::flush(SDL_Renderer* renderer)
+{
+    if (count == 0) return 0;
+    SDL_RenderGeometry(renderer, texture, vertices.data(), (int)vertices.size(), indices.data(), count * 6);
+    return 1;
+}
+
+void SpriteBatch::destroy()
+{
+}
+
+void SpriteBatch::setCompositing(bool)
+{
+}
+
+bool SpriteBatch::compositing() const
+{
+    return false;
+}
+
+#else
+
+void SpriteBatch::setCompositing(bool enabled)
+{
+    if (!enabled) destroy();
+    composite = enabled;
+}
+
+bool SpriteBatch::compositing() const
+{
+    return composite;
+}
+
+// (Re)creates the frame surface and texture when the render target's size
+// changes. Returns false if either cannot be made.
+bool SpriteBatch::prepareFrame(SDL_Renderer* renderer)
+{
+    int width = 0;
+    int height = 0;
+    SDL_Texture* target = SDL_GetRenderTarget(renderer);
+    if (target != NULL) SDL_QueryTexture(target, NULL, NULL, &width, &height);
+    else SDL_RenderGetLogicalSize(renderer, &width, &height);
+    if (target == NULL && width == 0) SDL_GetRendererOutputSize(renderer, &width, &height);
+    if (width <= 0 || height <= 0) return false;
+    if (frame != NULL && frame->w == width && frame->h == height && frame->format->format == sheet->format->format) {
+        return true;
+    }
+
+    destroy();
+    frame = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, sheet->format->format);
+    frameTexture = SDL_CreateTexture(renderer, sheet->format->format, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (frame == NULL || frameTexture == NULL) {
+        destroy();
+        return false;
+    }
+    SDL_FillRect(frame, NULL, 0);
+    SDL_UpdateTexture(frameTexture, NULL, frame->pixels, frame->pitch);
+
+    // Blending sprites onto a transparent surface leaves colour multiplied
+    // by alpha, so the texture is drawn with premultiplied-alpha blending.
+    // Renderers without custom blend modes get plain blending, which only
+    // darkens the sprites' soft edges a little.
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(frameTexture, premultiplied) != 0) SDL_SetTextureBlendMode(frameTexture, SDL_BLENDMODE_BLEND);
+    drawn = { 0, 0, 0, 0 };
+    return true;
+}
+
+int SpriteBatch::flush(SDL_Renderer* renderer)
+{
+    if (count == 0) return 0;
+    if (!composite || sheet == NULL || !prepareFrame(renderer)) {
+        // Not compositing, or no frame surface to compose into: draw the
+        // sprites one by one.
+        for (int i = 0; i < count; i++) SDL_RenderCopy(renderer, texture, &sources[i], &targets[i]);
+        return count;
+    }
+
+    SDL_Rect screen = { 0, 0, frame->w, frame->h };
+    SDL_Rect covered = targets[0];
+    for (int i = 1; i < count; i++) SDL_UnionRect(&covered, &targets[i], &covered);
+    if (!SDL_IntersectRect(&covered, &screen, &covered)) covered = { 0, 0, 0, 0 };
+
+    // Clear what the last frame left, then blend this frame's sprites in.
+    SDL_Rect dirty = covered;
+    if (!SDL_RectEmpty(&drawn)) SDL_UnionRect(&dirty, &drawn, &dirty);
+    if (SDL_RectEmpty(&dirty)) return 0;
+    SDL_FillRect(frame, &dirty, 0);
+    for (int i = 0; i < count; i++) {
+        SDL_Rect target = targets[i]; // the blits clip it in place
+        if (sources[i].w == target.w && sources[i].h == target.h) SDL_BlitSurface(sheet, &sources[i], frame, &target);
+        else SDL_BlitScaled(sheet, &sources[i], frame, &target);
+    }
+
+    const Uint8* pixels = (const Uint8*)frame->pixels + dirty.y * frame->pitch + dirty.x * 4;
+    SDL_UpdateTexture(frameTexture, &dirty, pixels, frame->pitch);
+    drawn = covered;
+    if (SDL_RectEmpty(&covered)) return 0;
+    SDL_RenderCopy(renderer, frameTexture, &covered, &covered);
+    return 1;
+}
+
+void SpriteBatch::destroy()
+{
+    if (frameTexture != NULL) SDL_DestroyTexture(frameTexture);
+    if (frame != NULL) SDL_FreeSurface(frame);
+    frameTexture = NULL;
+    frame = NULL;
+}
+
+#endif
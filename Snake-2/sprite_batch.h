@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+#include "sprite_atlas.h"
+
+// Collects sprite quads that all sample one atlas and submits them together
+// as a single draw call. With SDL 2.0.18+ the frame goes out as one
+// SDL_RenderGeometry call over a vertex/index buffer. Older SDL (the 2.0.8 we
+// ship) has no geometry API and by default draws each sprite with its own
+// SDL_RenderCopy from the atlas. setCompositing(true) instead blends the
+// quads on the CPU from the atlas' in-memory sheet into a frame surface the
+// size of the render target; only the area the sprites covered this frame or
+// last is cleared and uploaded to a streaming texture, which is then drawn
+// with one SDL_RenderCopy. That trades draw calls for CPU blending and an
+// upload per frame, so it stays opt-in (--composite-batch) until frame times
+// on 2.0.8 show it wins. Buffers are kept between frames, so steady-state
+// drawing does not allocate.
+class SpriteBatch {
+public:
+    void begin(const SpriteAtlas& atlas);
+    void add(const SDL_Rect& source, float x, float y, float w, float h);
+
+    // Draws everything added since begin(). Returns the number of draw calls made.
+    int flush(SDL_Renderer* renderer);
+
+    int sprites() const { return count; }
+
+    // Pre-2.0.18 SDL only; ignored with SDL_RenderGeometry.
+    void setCompositing(bool enabled);
+    bool compositing() const;
+
+    void destroy();
+
+private:
+    SDL_Texture* texture = NULL;
+    int atlasWidth = 1;
+    int atlasHeight = 1;
+    int count = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+#else
+    bool prepareFrame(SDL_Renderer* renderer);
+
+    SDL_Surface* sheet = NULL;
+    std::vector<SDL_Rect> sources;
+    std::vector<SDL_Rect> targets;
+    SDL_Surface* frame = NULL;        // premultiplied alpha, transparent where no sprite is
+    SDL_Texture* frameTexture = NULL; // streaming copy of frame
+    SDL_Rect drawn = { 0, 0, 0, 0 };  // area the last flush covered
+    bool composite = false;
+#endif
+};
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../core/asset_pack.h"
+#include "../core/batch_env.h"
+#include "../core/game.h"
+#include "../core/sparse_game.h"
+
+// SnakeTests [name]: regression checks for SnakeCore, one per bug fixed.
+// Runs every check, or only the named one; prints the failures and exits
+// non-zero if there were any. Best built with AddressSanitizer, since most
+// of these bugs were out-of-bounds writes. From the Snake-2 directory:
+//   g++ -std=c++17 -g -fsanitize=address,undefined tests/core_tests.cpp core/*.cpp -o SnakeTests -lpthread
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cout << "  " << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+            failures++; \
+        } \
+    } while (0)
+
+// A snake longer than the sparse body ring's first size is laid out whole.
+void sparseLongInitialSnake() {
+    GameConfig config;
+    config.width = SPARSE_MAX_SIDE;
+    config.height = SPARSE_MAX_SIDE;
+    config.initialLength = 3000;
+    SparseGame game;
+    newGame(game, config, 1);
+    CHECK(game.segments.size() == 3000);
+    CHECK(game.segments.front().y == SPARSE_MAX_SIDE / 2);
+    CHECK(game.segments.back().y == SPARSE_MAX_SIDE / 2 + 2999);
+    CHECK(game.occupied.test(game.segments.back()));
+    CHECK(updateSnake(game) == STEP_MOVE);
+}
+
+// The default length-3 snake on a board two cells tall is cut to fit.
+void shortBoardInitialSnake() {
+    GameConfig config;
+    config.width = 4;
+    config.height = 2;
+    GameState game;
+    newGame(game, config, 1);
+    CHECK(game.config.initialLength == 2);
+    CHECK(game.segments.size() == 2);
+    CHECK(game.segments.front().y == 0 && game.segments.back().y == 1);
+    for (int t = 0; t < 1000; t++) {
+        if (isGameOver(step(game, Direction(t / 3 % 4)))) initializeGame(game);
+    }
+}
+
+// BatchEnv on boards shorter than the default snake, and on a board small
+// enough to fill: games restart with STEP_BOARD_FULL instead of dividing by
+// the zero free cells left.
+void batchEnvSmallBoards() {
+    GameConfig shortBoard;
+    shortBoard.width = 4;
+    shortBoard.height = 2;
+    BatchEnv batch(8, shortBoard, 1);
+    CHECK(batch.config().initialLength == 2);
+    std::vector<uint8_t> actions(8), results(8);
+    for (int t = 0; t < 1000; t++) {
+        for (int i = 0; i < 8; i++) actions[i] = (uint8_t)((t / 3 + i) % 4);
+        batch.step(actions.data(), results.data());
+    }
+
+    GameConfig tiny;
+    tiny.width = 2;
+    tiny.height = 1;
+    BatchEnv full(1, tiny, 1);
+    CHECK(full.config().initialLength == 1);
+    uint8_t action = (uint8_t)(full.foodX(0) > full.headX(0) ? Direction::RIGHT : Direction::LEFT);
+    uint8_t result = 0;
+    full.step(&action, &result);
+    CHECK(result == STEP_BOARD_FULL);
+    CHECK(full.length(0) == 1);
+}
+
+// Two entries with one name would leave lookups picking either.
+void assetPackDuplicateNames() {
+    const char* file = "snake_tests_entry.tmp";
+    const char* pack = "snake_tests.pak";
+    std::ofstream(file) << "x";
+    CHECK(writeAssetPack(pack, { "img/a.png", "img/b.png" }, { file, file }));
+    CHECK(!writeAssetPack(pack, { "img/a.png", "img/b.png", "img/a.png" }, { file, file, file }));
+    std::remove(file);
+    std::remove(pack);
+}
+
+struct TestEntry {
+    const char* name;
+    void (*run)();
+};
+
+const TestEntry tests[] = {
+    { "sparse-long-initial-snake", sparseLongInitialSnake },
+    { "short-board-initial-snake", shortBoardInitialSnake },
+    { "batch-env-small-boards", batchEnvSmallBoards },
+    { "asset-pack-duplicate-names", assetPackDuplicateNames },
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int ran = 0;
+    for (const TestEntry& test : tests) {
+        if (argc >= 2 && strcmp(argv[1], test.name) != 0) continue;
+        int before = failures;
+        test.run();
+        std::cout << (failures == before ? "ok    " : "FAIL  ") << test.name << std::endl;
+        ran++;
+    }
+    if (ran == 0) {
+        std::cout << "no test named " << argv[1] << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
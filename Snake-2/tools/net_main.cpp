@@ -0,0 +1,238 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../core/rng.h"
+#include "../net/link_conditioner.h"
+#include "../net/rollback_session.h"
+#include "../net/udp_socket.h"
+
+// SnakeNet: two-player rollback netcode over UDP, played by bots whose
+// snakes share one small arena board.
+//
+//   SnakeNet local [options]
+//       both players in this process, talking over localhost; checks at the
+//       end that the two peers simulated identical boards
+//   SnakeNet peer --player 0|1 --port P --remote HOST:PORT [options]
+//       one player; run the other one elsewhere with the ports swapped
+//
+// Options: --frames N (600), --tick-rate HZ (60), --delay FRAMES (2),
+// --rollback FRAMES (8), --latency MS, --jitter MS, --loss PERCENT and
+// --seed N. Latency, jitter and loss are added to every datagram sent.
+
+namespace {
+
+struct NetOptions {
+    int player = 0;
+    uint16_t port = 0;
+    std::string remote;
+    int frames = 600;
+    double tickRate = 60;
+    int inputDelay = 2;
+    int maxRollback = 8;
+    uint64_t seed = 1;
+    LinkConditions conditions;
+};
+
+uint64_t nowMs() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// A board small enough that the two snakes keep running into each other and
+// going for the same food.
+ArenaConfig netArena() {
+    ArenaConfig config;
+    config.width = 16;
+    config.height = 12;
+    config.snakes = 2;
+    config.maxLength = 32;
+    config.food = 2;
+    config.respawnTicks = 4;
+    return config;
+}
+
+// Random player: a turn every eight frames or so.
+uint8_t botInput(Rng& rng) {
+    uint64_t x = rng.next();
+    return (x & 7) == 0 ? (uint8_t)((x >> 3) & 3) : INPUT_KEEP;
+}
+
+// One player's end: session, socket and the simulated link in front of it.
+struct Peer {
+    Peer(int player, const NetOptions& options, uint64_t linkSeed)
+        : session(player, netArena(), options.seed, options.inputDelay, options.maxRollback),
+          link(socket, options.conditions, linkSeed), bot(options.seed * 2 + player + 1) {}
+
+    void receive() {
+        uint8_t buffer[512];
+        NetAddress from;
+        int size;
+        while ((size = socket.receive(buffer, sizeof(buffer), from)) >= 0) {
+            session.readPacket(buffer, (size_t)size);
+        }
+    }
+
+    void send(uint64_t now) {
+        uint8_t buffer[RollbackSession::MAX_PACKET];
+        size_t size = session.writePacket(buffer);
+        link.send(remote, buffer, size, now);
+    }
+
+    // One tick: read, advance if there are frames left, send.
+    void update(int frames, uint64_t now) {
+        receive();
+        if ((int)session.frame() < frames) {
+            uint8_t input = botInput(bot);
+            if (!session.advance(input)) bot = botBefore; // the stalled frame's input is retried
+            else botBefore = bot;
+        }
+        else {
+            session.resolve();
+        }
+        send(now);
+        link.flush(now);
+    }
+
+    bool finished(int frames) const { return (int)session.confirmedFrames() >= frames; }
+
+    RollbackSession session;
+    UdpSocket socket;
+    LinkConditioner link;
+    NetAddress remote;
+    Rng bot;
+    Rng botBefore = bot;
+};
+
+// seconds: wall time the run took, for the per-second rates.
+void printStats(const char* name, const Peer& peer, double seconds) {
+    const RollbackStats& stats = peer.session.stats();
+    std::cout << name << ": " << stats.frames << " frames, " << stats.stalls << " stalls, "
+        << stats.mispredictions << " mispredictions, " << stats.rollbacks << " rollbacks ("
+        << (stats.rollbacks > 0 ? (double)stats.resimulatedFrames / stats.rollbacks : 0) << " frames avg, "
+        << stats.maxRollbackFrames << " max), packets " << peer.link.sent() << " sent, "
+        << peer.link.dropped() << " dropped, " << stats.packetsRead << " read" << std::endl;
+    std::cout << name << ": " << stats.rollbacks / seconds << " rollbacks/s, "
+        << stats.resimulatedFrames / seconds << " re-simulated frames/s, " << stats.localChanges
+        << " rollbacks changed the local snake";
+    if (stats.desyncs > 0) std::cout << ", DESYNCED (" << stats.desyncs << " corrections past the oldest snapshot)";
+    std::cout << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], NetOptions& options) {
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--player") == 0 && hasValue) options.player = atoi(argv[++i]) == 1 ? 1 : 0;
+        else if (strcmp(argv[i], "--port") == 0 && hasValue) options.port = (uint16_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--remote") == 0 && hasValue) options.remote = argv[++i];
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue) options.frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && hasValue) options.tickRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--delay") == 0 && hasValue) options.inputDelay = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rollback") == 0 && hasValue) options.maxRollback = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latency") == 0 && hasValue) options.conditions.latencyMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jitter") == 0 && hasValue) options.conditions.jitterMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--loss") == 0 && hasValue) options.conditions.loss = atof(argv[++i]) / 100;
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue) options.seed = strtoull(argv[++i], NULL, 10);
+        else return false;
+    }
+    return options.frames > 0 && options.tickRate > 0 && options.inputDelay >= 0 && options.maxRollback >= 1 &&
+        options.inputDelay + options.maxRollback < RollbackSession::INPUT_WINDOW / 2;
+}
+
+int runLocal(const NetOptions& options) {
+    std::unique_ptr<Peer> peers[2];
+    for (int p = 0; p < 2; p++) {
+        peers[p].reset(new Peer(p, options, options.seed + 100 + p));
+        if (!peers[p]->socket.open(0)) {
+            std::cout << "Cannot open a UDP socket" << std::endl;
+            return 1;
+        }
+    }
+    for (int p = 0; p < 2; p++) resolveAddress("127.0.0.1", peers[1 - p]->socket.port(), peers[p]->remote);
+
+    auto tick = std::chrono::duration<double>(1.0 / options.tickRate);
+    auto next = std::chrono::steady_clock::now();
+    auto start = next;
+    // Extra time for the last inputs to arrive through the simulated link.
+    auto deadline = start + tick * options.frames * 4 + std::chrono::seconds(5);
+    while (!(peers[0]->finished(options.frames) && peers[1]->finished(options.frames))) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            std::cout << "Timed out waiting for the peers to confirm every frame" << std::endl;
+            return 1;
+        }
+        uint64_t now = nowMs();
+        for (int p = 0; p < 2; p++) peers[p]->update(options.frames, now);
+        if (peers[0]->session.desynced() || peers[1]->session.desynced()) break;
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick);
+        std::this_thread::sleep_until(next);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << options.frames << " frames at " << options.tickRate << " Hz in " << elapsed.count() << " s, latency "
+        << options.conditions.latencyMs << " ms +/- " << options.conditions.jitterMs << " ms, loss "
+        << options.conditions.loss * 100 << "%, input delay " << options.inputDelay << " frames" << std::endl;
+    printStats("player 0", *peers[0], elapsed.count());
+    printStats("player 1", *peers[1], elapsed.count());
+
+    const ArenaStats& board = peers[0]->session.board().stats();
+    std::cout << "board: " << board.headDeaths << " head-on deaths, " << board.bodyDeaths << " body deaths, "
+        << board.wallDeaths << " wall deaths, " << board.foodEaten << " food eaten" << std::endl;
+
+    bool same = !peers[0]->session.desynced() && !peers[1]->session.desynced() &&
+        peers[0]->session.checksum() == peers[1]->session.checksum();
+    std::cout << (same ? "Both peers agree on the board" : "DESYNC: the peers' boards differ") << std::endl;
+    return same ? 0 : 2;
+}
+
+int runPeer(const NetOptions& options) {
+    Peer peer(options.player, options, options.seed + 100 + options.player);
+    size_t colon = options.remote.rfind(':');
+    if (colon == std::string::npos ||
+        !resolveAddress(options.remote.substr(0, colon).c_str(), (uint16_t)atoi(options.remote.c_str() + colon + 1), peer.remote)) {
+        std::cout << "--remote needs HOST:PORT" << std::endl;
+        return 1;
+    }
+    if (!peer.socket.open(options.port)) {
+        std::cout << "Cannot open UDP port " << options.port << std::endl;
+        return 1;
+    }
+
+    auto tick = std::chrono::duration<double>(1.0 / options.tickRate);
+    auto next = std::chrono::steady_clock::now();
+    // Keep sending for a while after finishing so the other side gets our
+    // last inputs too.
+    int lingerTicks = (int)(options.tickRate * 2);
+    auto start = next;
+    while (lingerTicks > 0 && !peer.session.desynced()) {
+        peer.update(options.frames, nowMs());
+        if (peer.finished(options.frames)) lingerTicks--;
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick);
+        std::this_thread::sleep_until(next);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    printStats(options.player == 0 ? "player 0" : "player 1", peer, elapsed.count());
+    if (peer.session.desynced()) return 2;
+    std::cout << "Checksum: " << peer.session.checksum() << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    NetOptions options;
+    bool local = argc >= 2 && strcmp(argv[1], "local") == 0;
+    bool peer = argc >= 2 && strcmp(argv[1], "peer") == 0;
+    if ((!local && !peer) || !parseOptions(argc, argv, options) || (peer && options.remote.empty())) {
+        std::cout << "usage: SnakeNet local [options]" << std::endl;
+        std::cout << "       SnakeNet peer --player 0|1 --port P --remote HOST:PORT [options]" << std::endl;
+        std::cout << "options: --frames N --tick-rate HZ --delay FRAMES --rollback FRAMES" << std::endl;
+        std::cout << "         --latency MS --jitter MS --loss PERCENT --seed N" << std::endl;
+        return 1;
+    }
+    return local ? runLocal(options) : runPeer(options);
+}
@@ -0,0 +1,50 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../core/asset_pack.h"
+
+// SnakePack <output.pak> <directory>...
+//
+// Bundles every file under the given directories into one archive. Entry
+// names keep the directory's own name, so packing img and sfx from the game
+// directory gives "img/apple.png", "sfx/bite.mp3" and so on, with or
+// without a trailing slash. Hidden files are skipped, and two files that
+// would get the same name (the same directory given twice, say) are an
+// error.
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "usage: SnakePack <output.pak> <directory>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::string> files;
+    for (int i = 2; i < argc; i++) {
+        // Absolute and without a trailing slash, so "img", "img/" and
+        // "./img" all name their entries "img/..." and "." uses the
+        // current directory's own name.
+        std::error_code error;
+        std::filesystem::path root = std::filesystem::absolute(argv[i], error).lexically_normal();
+        if (!root.has_filename()) root = root.parent_path();
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(root, error)) {
+            if (!entry.is_regular_file()) continue;
+            if (entry.path().filename().string()[0] == '.') continue; // .DS_Store and friends
+            std::filesystem::path relative = entry.path().lexically_relative(root.parent_path());
+            names.push_back(relative.generic_string());
+            files.push_back(entry.path().string());
+        }
+        if (error) {
+            std::cout << "Cannot read " << argv[i] << ": " << error.message() << std::endl;
+            return 1;
+        }
+    }
+
+    if (!writeAssetPack(argv[1], names, files)) {
+        std::cout << "Failed to write " << argv[1] << ": a file could not be read or two files share an entry name" << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << names.size() << " files into " << argv[1] << std::endl;
+    return 0;
+}
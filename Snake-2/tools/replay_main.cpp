@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/game.h"
+#include "../core/mapped_file.h"
+#include "../core/replay_analysis.h"
+#include "../core/thread_pool.h"
+
+// SnakeReplay [--threads N] [--out DIR] <replay file or directory>...
+//
+// Re-simulates every replay on all cores and checks that each one plays to
+// its end marker. Per-game results go to DIR (default replay_stats) as one
+// raw little-endian file per column, readable with e.g. numpy.fromfile:
+//
+//   replay.u32 game.u32 ticks.u32 final_length.u32 cause.u8
+//   curve_begin.u64 curve_ticks.u32   (length curve, see ReplayColumns)
+
+namespace {
+
+template <typename T>
+bool writeColumn(const std::filesystem::path& path, const std::vector<T>& column) {
+    FILE* file = fopen(path.string().c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(column.data(), sizeof(T), column.size(), file) == column.size();
+    return fclose(file) == 0 && ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int threads = (int)std::thread::hardware_concurrency();
+    std::filesystem::path outDir = "replay_stats";
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        }
+        else if (std::filesystem::is_directory(argv[i])) {
+            for (const auto& entry : std::filesystem::directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) paths.push_back(entry.path().string());
+            }
+        }
+        else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::cout << "usage: SnakeReplay [--threads N] [--out DIR] <replay file or directory>..." << std::endl;
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+
+    // Each replay gets its own columns so workers never share a vector; they
+    // are joined in input order afterwards, so the output does not depend on
+    // scheduling.
+    std::vector<ReplayColumns> perReplay(paths.size());
+    std::vector<uint8_t> valid(paths.size(), 0);
+    ThreadPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(0, (int)paths.size(), 16, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) {
+            MappedFile file;
+            if (!file.open(paths[i].c_str())) continue;
+            valid[i] = analyzeReplay(file.data(), file.size(), (uint32_t)i, perReplay[i]);
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    ReplayColumns columns;
+    uint64_t totalTicks = 0;
+    uint64_t causes[STEP_BOARD_FULL + 1] = {};
+    size_t invalid = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        columns.append(perReplay[i]);
+        if (!valid[i]) {
+            invalid++;
+            std::cout << "INVALID " << paths[i] << std::endl;
+        }
+    }
+    for (size_t i = 0; i < columns.rows(); i++) {
+        totalTicks += columns.ticks[i];
+        causes[columns.cause[i]]++;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outDir, error);
+    bool written = writeColumn(outDir / "replay.u32", columns.replay)
+        && writeColumn(outDir / "game.u32", columns.game)
+        && writeColumn(outDir / "ticks.u32", columns.ticks)
+        && writeColumn(outDir / "final_length.u32", columns.finalLength)
+        && writeColumn(outDir / "cause.u8", columns.cause)
+        && writeColumn(outDir / "curve_begin.u64", columns.curveBegin)
+        && writeColumn(outDir / "curve_ticks.u32", columns.curveTicks);
+    if (!written) std::cout << "Failed to write columns to " << outDir.string() << std::endl;
+
+    std::cout << paths.size() << " replays (" << invalid << " invalid), " << columns.rows() << " games, "
+        << totalTicks << " ticks in " << elapsed.count() * 1000 << " ms on " << pool.size() << " threads" << std::endl;
+    std::cout << (double)columns.rows() / elapsed.count() << " games/sec, "
+        << totalTicks / elapsed.count() / 1e6 << " M ticks/sec" << std::endl;
+    std::cout << "Deaths: wall " << causes[STEP_CRASH_WALL] << ", self " << causes[STEP_CRASH_SELF]
+        << ", board full " << causes[STEP_BOARD_FULL] << ", unfinished " << causes[0] << std::endl;
+    return invalid == 0 && written ? 0 : 2;
+}